@@ -50,6 +50,7 @@
 
 #include "utf8/checked.h"
 #include "utf8/unchecked.h"
+#include "utf8/simd.h"
 
 #endif          // UTFCPP_UTF8_UTF8_H
 
@@ -0,0 +1,166 @@
+#if ! defined UTFCPP_UTF8_SIMD_H
+#define UTFCPP_UTF8_SIMD_H
+
+/*
+ * Chris Ahlstrom 2026-10-16
+ * Not part of the original utfcpp.  Provides a fast validity check for the
+ * common case of text that is mostly or entirely ASCII, so that callers can
+ * avoid utf8::replace_invalid() and its copy when there is nothing to
+ * replace.
+ *
+ * The ASCII runs are skipped 32 bytes at a time with AVX2 (if the CPU has
+ * it, checked once at run time), otherwise 16 at a time with SSE2, and 8 at
+ * a time with plain 64-bit words on other targets.  Each non-ASCII sequence
+ * is then checked with utf8::internal::validate_next(), so the result is
+ * always the same as utf8::is_valid().
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "core.h"
+
+#if defined __SSE2__ && (defined __GNUC__ || defined __clang__)
+#include <immintrin.h>
+#define UTF_CPP_SIMD_SSE2
+#if defined __x86_64__ || defined __i386__
+#define UTF_CPP_SIMD_AVX2
+#endif
+#endif
+
+namespace utf8
+{
+
+namespace simd
+{
+
+namespace internal
+{
+
+inline std::size_t
+ascii_length_scalar (const char * s, std::size_t n)
+{
+    const std::uint64_t high { 0x8080808080808080ULL };
+    std::size_t i { 0 };
+    for ( ; i + 8 <= n; i += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, s + i, sizeof word);
+        if ((word & high) != 0)
+            break;
+    }
+    while (i < n && static_cast<unsigned char>(s[i]) < 0x80)
+        ++i;
+
+    return i;
+}
+
+#if defined UTF_CPP_SIMD_SSE2
+
+inline std::size_t
+ascii_length_sse2 (const char * s, std::size_t n)
+{
+    std::size_t i { 0 };
+    for ( ; i + 16 <= n; i += 16)
+    {
+        __m128i x { _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i)) };
+        unsigned mask { unsigned(_mm_movemask_epi8(x)) };
+        if (mask != 0)
+            return i + unsigned(__builtin_ctz(mask));
+    }
+    return i + ascii_length_scalar(s + i, n - i);
+}
+
+#endif
+
+#if defined UTF_CPP_SIMD_AVX2
+
+__attribute__((target("avx2")))
+inline std::size_t
+ascii_length_avx2 (const char * s, std::size_t n)
+{
+    std::size_t i { 0 };
+    for ( ; i + 32 <= n; i += 32)
+    {
+        __m256i x
+        {
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i))
+        };
+        unsigned mask { unsigned(_mm256_movemask_epi8(x)) };
+        if (mask != 0)
+            return i + unsigned(__builtin_ctz(mask));
+    }
+    return i + ascii_length_sse2(s + i, n - i);
+}
+
+inline bool
+has_avx2 ()
+{
+    static const bool s_has_avx2 { __builtin_cpu_supports("avx2") != 0 };
+    return s_has_avx2;
+}
+
+#endif
+
+}           // namespace internal
+
+/**
+ *  Returns the length of the run of ASCII bytes at the start of s.
+ */
+
+inline std::size_t
+ascii_length (const char * s, std::size_t n)
+{
+#if defined UTF_CPP_SIMD_AVX2
+    if (n >= 64 && internal::has_avx2())
+        return internal::ascii_length_avx2(s, n);
+#endif
+#if defined UTF_CPP_SIMD_SSE2
+    return internal::ascii_length_sse2(s, n);
+#else
+    return internal::ascii_length_scalar(s, n);
+#endif
+}
+
+/**
+ *  Same result as utf8::is_valid(), but much faster for ASCII text.
+ */
+
+inline bool
+is_valid (const char * s, std::size_t n)
+{
+    const char * ender { s + n };
+    for (;;)
+    {
+        s += ascii_length(s, std::size_t(ender - s));
+        while (s != ender && static_cast<unsigned char>(*s) >= 0x80)
+        {
+            utf8::internal::utf_error err
+            {
+                utf8::internal::validate_next(s, ender)
+            };
+            if (err != utf8::internal::UTF8_OK)
+                return false;
+        }
+        if (s == ender)
+            return true;
+    }
+}
+
+inline bool
+is_valid (const std::string & s)
+{
+    return is_valid(s.data(), s.size());
+}
+
+}           // namespace simd
+
+}           // namespace utf8
+
+#endif      // UTFCPP_UTF8_SIMD_H
+
+/*
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,133 @@
+#if ! defined XML66_XML_XML66ARENA_HPP
+#define XML66_XML_XML66ARENA_HPP
+
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66arena.hpp
+ *
+ *    Provides a monotonic arena for the XMLNode and XMLProperty objects of
+ *    an XMLTree.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ *
+ *  Reading a document allocates one XMLNode per element and one XMLProperty
+ *  per attribute, and destroying the tree frees them one at a time.  An
+ *  XMLTree in arena mode instead owns an XMLArena, and while it reads, the
+ *  arena is made current for the thread with an XMLArena::scope.  The
+ *  operator new of XMLNode takes memory from the current arena, if any,
+ *  and otherwise is the plain heap allocation, with no overhead.  The
+ *  property slots of a node come from the same place.  The arena's memory
+ *  is released all at once when the tree is destroyed or read again.
+ *
+ *  Arena and heap nodes can be mixed freely in one tree:  nodes added
+ *  later by the caller, or converted on demand by the lazy mode, come from
+ *  the heap.  A node learns where it came from by claim()ing its address
+ *  as it is constructed, and its destructor reports an arena node with
+ *  destroyed(), so that operator delete leaves that memory alone.
+ *
+ *  XMLTree tears down an arena tree in one flat pass that abandons the
+ *  arena nodes owning no heap memory of their own, without running their
+ *  destructors.  The others are still destroyed in place, since their
+ *  longer strings and their child lists are ordinary heap objects.
+ */
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace xml66
+{
+
+/**
+ * XMLArena
+ */
+
+class XMLArena
+{
+
+public:
+
+    /**
+     *  Makes an arena current for the calling thread for the lifetime of
+     *  the scope.  A null arena makes allocations use the heap.  Scopes
+     *  nest.
+     */
+
+    class scope
+    {
+
+    private:
+
+        XMLArena * m_prior;
+
+    public:
+
+        explicit scope (XMLArena * arena);
+        ~scope ();
+
+        scope (const scope &) = delete;
+        scope & operator = (const scope &) = delete;
+
+    };          // class scope
+
+private:
+
+    std::pmr::monotonic_buffer_resource m_resource;
+    std::size_t m_bytes;
+
+public:
+
+    explicit XMLArena (std::size_t initial_size = 16 * 1024);
+
+    XMLArena (const XMLArena &) = delete;
+    XMLArena & operator = (const XMLArena &) = delete;
+
+    void * allocate (std::size_t bytes, std::size_t alignment);
+    void release ();
+
+    /**
+     *  The number of bytes handed out since the last release().
+     */
+
+    std::size_t bytes () const
+    {
+        return m_bytes;
+    }
+
+    static XMLArena * current ();
+    static void * allocate_object (std::size_t bytes);
+    static void deallocate_object (void * p);
+    static bool claim (const void * object);
+    static void destroyed (const void * object);
+
+};          // class XMLArena
+
+}           // namespace xml66
+
+#endif      // XML66_XML_XML66ARENA_HPP
+
+/*
+ * xml66arena.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,542 @@
+#if ! defined XML66_XML_XML66FROZEN_HPP
+#define XML66_XML_XML66FROZEN_HPP
+
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66frozen.hpp
+ *
+ *    Provides a compact, read-only copy of an XMLNode tree.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ *
+ *  Many documents are only queried after they are loaded.  XMLTree::freeze()
+ *  copies the tree into an XMLFrozenTree, which numbers the nodes in
+ *  depth-first order and keeps each field of the nodes in its own array:
+ *  names, parent, first-child, and next-sibling indices, property ranges,
+ *  and content ranges.  All property values and content share one string
+ *  pool, and names are the interned XMLName atoms.  There is one
+ *  allocation per array instead of several per node, and a traversal
+ *  reads memory in order.
+ *
+ *  An XMLFrozenNode is a small handle (the tree and an index) whose
+ *  getters mirror those of XMLNode.  Handles, and the string views they
+ *  return, are valid while the frozen tree exists and is not moved.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "xml/xml66name.hpp"            /* xml66::XMLName interned names    */
+#include "util/strconversions.hpp"      /* util::string_to<> templates      */
+
+namespace xml66
+{
+
+class XMLNode;
+class XMLFrozenTree;
+
+/**
+ *  A property of a frozen node, returned by value.
+ */
+
+class XMLFrozenProperty
+{
+
+private:
+
+    XMLName m_name;
+    std::string_view m_value;
+
+public:
+
+    XMLFrozenProperty (XMLName n, std::string_view v) :
+        m_name  (n),
+        m_value (v)
+    {
+        // No code
+    }
+
+    const std::string & name () const
+    {
+        return m_name.str();
+    }
+
+    XMLName atom () const
+    {
+        return m_name;
+    }
+
+    std::string_view value () const
+    {
+        return m_value;
+    }
+
+};          // class XMLFrozenProperty
+
+/**
+ *  A handle to a node of an XMLFrozenTree.  A default-constructed handle,
+ *  or one returned for a missing node, is not valid().
+ */
+
+class XMLFrozenNode
+{
+
+    friend class XMLFrozenTree;
+
+public:
+
+    using index = std::uint32_t;
+
+    static constexpr index c_none { UINT32_MAX };
+
+    /**
+     *  Walks a chain of siblings.
+     */
+
+    class sibling_iterator
+    {
+
+    public:
+
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = XMLFrozenNode;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const XMLFrozenNode *;
+        using reference         = XMLFrozenNode;
+
+    private:
+
+        const XMLFrozenTree * m_tree;
+        index m_index;
+
+    public:
+
+        sibling_iterator (const XMLFrozenTree * tree, index i) :
+            m_tree  (tree),
+            m_index (i)
+        {
+            // No code
+        }
+
+        XMLFrozenNode operator * () const
+        {
+            return XMLFrozenNode(m_tree, m_index);
+        }
+
+        sibling_iterator & operator ++ ();
+
+        bool operator == (const sibling_iterator & rhs) const
+        {
+            return m_index == rhs.m_index;
+        }
+
+        bool operator != (const sibling_iterator & rhs) const
+        {
+            return m_index != rhs.m_index;
+        }
+
+    };          // class sibling_iterator
+
+    /**
+     *  The children of a node, for range-for loops.
+     */
+
+    class child_range
+    {
+
+    private:
+
+        const XMLFrozenTree * m_tree;
+        index m_first;
+
+    public:
+
+        child_range (const XMLFrozenTree * tree, index first) :
+            m_tree  (tree),
+            m_first (first)
+        {
+            // No code
+        }
+
+        sibling_iterator begin () const
+        {
+            return sibling_iterator(m_tree, m_first);
+        }
+
+        sibling_iterator end () const
+        {
+            return sibling_iterator(m_tree, c_none);
+        }
+
+    };          // class child_range
+
+    /**
+     *  The properties of a node, for range-for loops.
+     */
+
+    class property_range
+    {
+
+    public:
+
+        class iterator
+        {
+
+        private:
+
+            const XMLFrozenTree * m_tree;
+            index m_index;
+
+        public:
+
+            iterator (const XMLFrozenTree * tree, index i) :
+                m_tree  (tree),
+                m_index (i)
+            {
+                // No code
+            }
+
+            XMLFrozenProperty operator * () const;
+
+            iterator & operator ++ ()
+            {
+                ++m_index;
+                return *this;
+            }
+
+            bool operator != (const iterator & rhs) const
+            {
+                return m_index != rhs.m_index;
+            }
+
+        };      // class iterator
+
+    private:
+
+        const XMLFrozenTree * m_tree;
+        index m_begin;
+        index m_end;
+
+    public:
+
+        property_range (const XMLFrozenTree * tree, index b, index e) :
+            m_tree  (tree),
+            m_begin (b),
+            m_end   (e)
+        {
+            // No code
+        }
+
+        iterator begin () const
+        {
+            return iterator(m_tree, m_begin);
+        }
+
+        iterator end () const
+        {
+            return iterator(m_tree, m_end);
+        }
+
+        std::size_t size () const
+        {
+            return std::size_t(m_end - m_begin);
+        }
+
+    };          // class property_range
+
+private:
+
+    const XMLFrozenTree * m_tree;
+    index m_index;
+
+    XMLFrozenNode (const XMLFrozenTree * tree, index i) :
+        m_tree  (tree),
+        m_index (i)
+    {
+        // No code
+    }
+
+public:
+
+    XMLFrozenNode () : m_tree (nullptr), m_index (c_none)
+    {
+        // No code
+    }
+
+    bool valid () const
+    {
+        return m_index != c_none;
+    }
+
+    explicit operator bool () const
+    {
+        return valid();
+    }
+
+    bool operator == (const XMLFrozenNode & rhs) const
+    {
+        return m_tree == rhs.m_tree && m_index == rhs.m_index;
+    }
+
+    bool operator != (const XMLFrozenNode & rhs) const
+    {
+        return ! (*this == rhs);
+    }
+
+    /**
+     *  The position of the node in depth-first order.
+     */
+
+    index position () const
+    {
+        return m_index;
+    }
+
+    const std::string & name () const;
+    XMLName atom () const;
+    bool is_content () const;
+    std::string_view content () const;
+    std::string_view child_content () const;
+    XMLFrozenNode parent () const;
+    XMLFrozenNode first_child () const;
+    XMLFrozenNode next_sibling () const;
+    child_range children () const;
+    XMLFrozenNode child (const char * name) const;
+    property_range properties () const;
+    bool has_property (const char * name) const;
+    bool get_property (const char * name, std::string & value) const;
+
+    template <class T>
+    bool get_property (const char * name, T & value) const
+    {
+        std::string text;
+        if (! get_property(name, text))
+            return false;
+
+        return util::string_to<T> (text, value);            /* PBD  */
+    }
+
+    bool has_property_with_value
+    (
+        const std::string & name, const std::string & value
+    ) const;
+
+    XMLNode * thaw () const;
+
+};          // class XMLFrozenNode
+
+/**
+ * XMLFrozenTree
+ */
+
+class XMLFrozenTree
+{
+
+    friend class XMLFrozenNode;
+
+    using index = XMLFrozenNode::index;
+
+    /**
+     *  A piece of m_pool.
+     */
+
+    struct text_range
+    {
+        index offset;
+        index length;
+    };
+
+private:
+
+    std::vector<XMLName>    m_names { };
+    std::vector<index>      m_parent { };
+    std::vector<index>      m_first_child { };
+    std::vector<index>      m_next_sibling { };
+
+    /*
+     * The properties of node i are m_prop_begin[i] up to m_prop_begin[i + 1]
+     * in the property arrays.  The extra last entry ends the final node's.
+     */
+
+    std::vector<index>      m_prop_begin { };
+    std::vector<XMLName>    m_prop_names { };
+    std::vector<text_range> m_prop_values { };
+    std::vector<text_range> m_content { };
+    std::vector<bool>       m_is_content { };
+    std::string             m_pool { };
+
+public:
+
+    XMLFrozenTree () = default;
+    explicit XMLFrozenTree (const XMLNode & root);
+
+    /*
+     * Handles point at the tree object, so a copy would be a trap; a moved
+     * tree needs new handles.  Views into m_pool are made on each access,
+     * since moving a short std::string moves its characters.
+     */
+
+    XMLFrozenTree (const XMLFrozenTree &) = delete;
+    XMLFrozenTree & operator = (const XMLFrozenTree &) = delete;
+    XMLFrozenTree (XMLFrozenTree &&) = default;
+    XMLFrozenTree & operator = (XMLFrozenTree &&) = default;
+
+    XMLFrozenNode root () const
+    {
+        return XMLFrozenNode(this, m_names.empty() ? XMLFrozenNode::c_none : 0);
+    }
+
+    /**
+     *  The node at a depth-first position, such as one saved from
+     *  XMLFrozenNode::position().
+     */
+
+    XMLFrozenNode node (index position) const
+    {
+        return XMLFrozenNode
+        (
+            this, position < m_names.size() ? position : XMLFrozenNode::c_none
+        );
+    }
+
+    std::size_t size () const
+    {
+        return m_names.size();
+    }
+
+    bool empty () const
+    {
+        return m_names.empty();
+    }
+
+    std::size_t property_count () const
+    {
+        return m_prop_names.size();
+    }
+
+    std::size_t memory_bytes () const;
+
+private:
+
+    index freeze (const XMLNode & n, index parent);
+    text_range add_text (const std::string & s);
+
+    std::string_view text (text_range r) const
+    {
+        return std::string_view(m_pool.data() + r.offset, r.length);
+    }
+
+};          // class XMLFrozenTree
+
+/*
+ * Inline functions of XMLFrozenNode, which need XMLFrozenTree.
+ */
+
+inline const std::string &
+XMLFrozenNode::name () const
+{
+    return m_tree->m_names[m_index].str();
+}
+
+inline XMLName
+XMLFrozenNode::atom () const
+{
+    return m_tree->m_names[m_index];
+}
+
+inline bool
+XMLFrozenNode::is_content () const
+{
+    return m_tree->m_is_content[m_index];
+}
+
+inline std::string_view
+XMLFrozenNode::content () const
+{
+    return m_tree->text(m_tree->m_content[m_index]);
+}
+
+inline XMLFrozenNode
+XMLFrozenNode::parent () const
+{
+    return XMLFrozenNode(m_tree, m_tree->m_parent[m_index]);
+}
+
+inline XMLFrozenNode
+XMLFrozenNode::first_child () const
+{
+    return XMLFrozenNode(m_tree, m_tree->m_first_child[m_index]);
+}
+
+inline XMLFrozenNode
+XMLFrozenNode::next_sibling () const
+{
+    return XMLFrozenNode(m_tree, m_tree->m_next_sibling[m_index]);
+}
+
+inline XMLFrozenNode::child_range
+XMLFrozenNode::children () const
+{
+    return child_range(m_tree, m_tree->m_first_child[m_index]);
+}
+
+inline XMLFrozenNode::sibling_iterator &
+XMLFrozenNode::sibling_iterator::operator ++ ()
+{
+    m_index = m_tree->m_next_sibling[m_index];
+    return *this;
+}
+
+inline XMLFrozenNode::property_range
+XMLFrozenNode::properties () const
+{
+    return property_range
+    (
+        m_tree, m_tree->m_prop_begin[m_index], m_tree->m_prop_begin[m_index + 1]
+    );
+}
+
+inline XMLFrozenProperty
+XMLFrozenNode::property_range::iterator::operator * () const
+{
+    return XMLFrozenProperty
+    (
+        m_tree->m_prop_names[m_index],
+        m_tree->text(m_tree->m_prop_values[m_index])
+    );
+}
+
+}           // namespace xml66
+
+#endif      // XML66_XML_XML66FROZEN_HPP
+
+/*
+ * xml66frozen.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
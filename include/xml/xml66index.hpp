@@ -0,0 +1,170 @@
+#if ! defined XML66_XML_XML66INDEX_HPP
+#define XML66_XML_XML66INDEX_HPP
+
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66index.hpp
+ *
+ *    Provides an index of elements by the value of one attribute.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ *
+ *  An XMLIndex maps each value of an attribute to the elements of one name
+ *  that have it, so that XMLXPath can answer a step such as
+ *  "Source[@id='1234']" with one hash lookup instead of visiting every
+ *  node.  XMLTree::build_index() creates them; XMLTree::find() passes them
+ *  to XMLXPath::select().
+ *
+ *  An index holds pointers into the tree it was built from.  XMLTree keeps
+ *  it current as its nodes change (see XMLEdits):  a change of the
+ *  attribute moves one entry, and a removed subtree drops its entries, in
+ *  place.  Only a subtree added with elements of the indexed name, whose
+ *  place in document order is not known, makes the index stale, to be
+ *  built again on first use.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "xml/xml66name.hpp"            /* xml66::XMLName interned names    */
+
+namespace xml66
+{
+
+class XMLNode;
+
+/**
+ * XMLIndex
+ */
+
+class XMLIndex
+{
+
+public:
+
+    /**
+     *  An indexed element, its parent, which is null for the root, and its
+     *  position among the elements of its name, in document order.
+     */
+
+    struct entry
+    {
+        const XMLNode * node;
+        const XMLNode * parent;
+        std::size_t order;
+    };
+
+    using entry_list = std::vector<entry>;
+
+private:
+
+    XMLName m_element;
+    XMLName m_attribute;
+
+    /*
+     * The elements having each value, in document order.
+     */
+
+    std::unordered_map<std::string, entry_list> m_entries { };
+    std::size_t m_size { 0 };
+
+    /*
+     * Every element of the indexed name, with or without the attribute,
+     * with its parent and position, so that its entry can be placed when
+     * the attribute changes.
+     */
+
+    std::unordered_map<const XMLNode *, entry> m_elements { };
+    bool m_stale { false };
+
+public:
+
+    XMLIndex (XMLName element, XMLName attribute);
+
+    void build (const XMLNode & root);
+    const entry_list & lookup (const std::string & value) const;
+    void update
+    (
+        const XMLNode & node,
+        const std::string * before, const std::string * after
+    );
+    void added (const XMLNode & subtree);
+    void removing (const XMLNode & subtree);
+
+    /**
+     *  True if a change could not be applied in place, and the index must
+     *  be built again.
+     */
+
+    bool stale () const
+    {
+        return m_stale;
+    }
+
+    void invalidate ()
+    {
+        m_stale = true;
+    }
+
+    XMLName element () const
+    {
+        return m_element;
+    }
+
+    XMLName attribute () const
+    {
+        return m_attribute;
+    }
+
+    /**
+     *  The number of indexed elements.
+     */
+
+    std::size_t size () const
+    {
+        return m_size;
+    }
+
+private:
+
+    void add (const XMLNode & node, const XMLNode * parent);
+    void insert (const std::string & value, const entry & e);
+    void erase (const std::string & value, const entry & e);
+
+};          // class XMLIndex
+
+using XMLIndexList = std::vector<std::shared_ptr<XMLIndex>>;
+
+}           // namespace xml66
+
+#endif      // XML66_XML_XML66INDEX_HPP
+
+/*
+ * xml66index.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,114 @@
+#if ! defined XML66_XML_XML66NAME_HPP
+#define XML66_XML_XML66NAME_HPP
+
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66name.hpp
+ *
+ *    Provides interned element and attribute names.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ *
+ *  An XMLName is a pointer to the one copy of its string in a name table,
+ *  so every node named "Port" shares a single "Port", and two names are
+ *  equal exactly when their pointers are.
+ *
+ *  The table is shared by the whole process rather than owned by each
+ *  XMLTree, because nodes are created on their own and moved from one tree
+ *  to another, and their names must stay valid and comparable throughout.
+ *  Names are never removed; a document vocabulary is small.  The table is
+ *  thread-safe, and each thread keeps a cache of the names it has looked
+ *  up, so the shared table is locked only for names new to the thread.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace xml66
+{
+
+/**
+ * XMLName
+ */
+
+class XMLName
+{
+
+private:
+
+    const std::string * m_atom;
+
+public:
+
+    /**
+     *  Hashes the atom, for unordered containers keyed by name.
+     */
+
+    struct hasher
+    {
+        std::size_t operator () (const XMLName & n) const
+        {
+            return std::hash<const std::string *>()(n.m_atom);
+        }
+    };
+
+    XMLName ();
+    explicit XMLName (std::string_view name);
+
+    const std::string & str () const
+    {
+        return *m_atom;
+    }
+
+    bool empty () const
+    {
+        return m_atom->empty();
+    }
+
+    bool operator == (const XMLName & rhs) const
+    {
+        return m_atom == rhs.m_atom;
+    }
+
+    bool operator != (const XMLName & rhs) const
+    {
+        return m_atom != rhs.m_atom;
+    }
+
+    static bool find (std::string_view name, XMLName & result);
+    static std::size_t table_size ();
+
+};          // class XMLName
+
+}           // namespace xml66
+
+#endif      // XML66_XML_XML66NAME_HPP
+
+/*
+ * xml66name.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,155 @@
+#if ! defined XML66_XML_XML66PARSER_HPP
+#define XML66_XML_XML66PARSER_HPP
+
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66parser.hpp
+ *
+ *    Provides a small native XML parser that builds the XMLNode tree
+ *    directly, without libxml2.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ *
+ *  The parser handles UTF-8 documents using the predefined entities and
+ *  character references.  It produces the same XMLNode tree that the
+ *  libxml2 path produces (with blank nodes removed), including libxml2's
+ *  heuristic for deciding which whitespace-only text is significant.
+ *
+ *  Anything outside of that subset (other encodings, entities declared in
+ *  a DTD, malformed input) makes parse() fail, and XMLTree then falls back
+ *  to libxml2, which also provides the error report.
+ *
+ *  It is built only if the 'native-parser' meson option is enabled, which
+ *  defines XML66_USE_NATIVE_PARSER.
+ */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace xml66
+{
+
+class XMLNode;
+
+/**
+ * XMLParser
+ */
+
+class XMLParser
+{
+
+private:
+
+    /**
+     *  An open element, plus what libxml2's blank-node heuristic needs to
+     *  know about it.  The space value follows libxml2's spaceTab: 1 for
+     *  xml:space="preserve", 0 for "default", -1 if unspecified, and -2
+     *  once the element has been seen to hold mixed content.
+     */
+
+    struct level
+    {
+        XMLNode * node;
+        const char * qname;
+        std::size_t qname_length;
+        std::size_t prefix_count;
+        int space;
+        bool first_is_text;
+        bool last_is_text;
+    };
+
+    /**
+     *  An attribute of the start tag being parsed.
+     */
+
+    struct attribute
+    {
+        const char * name;
+        std::size_t length;
+        std::string value;
+    };
+
+    const char * m_begin;
+    const char * m_cur;
+    const char * m_end;
+    XMLNode * m_root { nullptr };
+    std::string m_error { };
+    std::vector<level> m_stack { };
+    std::vector<attribute> m_attributes { };
+    std::size_t m_attribute_count { 0 };
+    std::vector<std::string> m_prefixes { };
+    std::string m_text { };
+    std::string m_value { };
+
+public:
+
+    XMLParser (const char * text, std::size_t len);
+    ~XMLParser () = default;
+
+    XMLParser (const XMLParser &) = delete;
+    XMLParser & operator = (const XMLParser &) = delete;
+
+    XMLNode * parse ();
+
+    const std::string & error_message () const
+    {
+        return m_error;
+    }
+
+private:
+
+    bool fail (const std::string & msg);
+    bool parse_xml_decl ();
+    bool skip_misc (bool prolog);
+    bool skip_doctype ();
+    bool parse_start_tag ();
+    bool parse_end_tag ();
+    std::string node_name (const char * p, const char * end) const;
+    bool parse_text ();
+    bool parse_comment (std::string & out);
+    bool parse_cdata (std::string & out);
+    bool parse_pi (std::string & target, std::string & data);
+    bool parse_reference (std::string & out);
+    bool parse_attribute_value (std::string & out);
+    void add_chunk
+    (
+        std::size_t lead, const char * p, const char * q,
+        char raw, char next
+    );
+    bool ignorable (char raw, char next) const;
+    void flush_text ();
+    void add_node (XMLNode * node, bool is_text);
+
+};          // class XMLParser
+
+}           // namespace xml66
+
+#endif      // XML66_XML_XML66PARSER_HPP
+
+/*
+ * xml66parser.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,136 @@
+#if ! defined XML66_XML_XML66POOL_HPP
+#define XML66_XML_XML66POOL_HPP
+
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66pool.hpp
+ *
+ *    Provides a pool of reusable libxml2 parser contexts.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ *
+ *  Creating a parser context allocates its input and node stacks, its SAX
+ *  handler, and a new name dictionary, which is then rebuilt as the
+ *  document is parsed.  For many small documents this costs as much as the
+ *  parsing.  XMLTree borrows a context from a pool instead, and the context
+ *  is cleared with xmlCtxtReset() when it is returned, keeping its buffers
+ *  and dictionary.
+ *
+ *  Each thread has a default pool, thread_pool(), so no locking is needed
+ *  in the common case.  An explicit pool can be shared by several trees,
+ *  even across threads; a mutex protects its list of idle contexts, and a
+ *  context is used by one parse at a time.
+ */
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include <libxml/parser.h>
+
+namespace xml66
+{
+
+/**
+ * XMLParserPool
+ */
+
+class XMLParserPool
+{
+
+public:
+
+    /**
+     *  Borrows a context for the lifetime of the lease.
+     */
+
+    class lease
+    {
+
+    private:
+
+        XMLParserPool & m_pool;
+        xmlParserCtxtPtr m_ctxt;
+
+    public:
+
+        explicit lease (XMLParserPool & pool) :
+            m_pool  (pool),
+            m_ctxt  (pool.acquire())
+        {
+            // No code
+        }
+
+        ~lease ()
+        {
+            m_pool.release(m_ctxt);
+        }
+
+        lease (const lease &) = delete;
+        lease & operator = (const lease &) = delete;
+
+        xmlParserCtxtPtr get () const
+        {
+            return m_ctxt;
+        }
+
+    };          // class lease
+
+private:
+
+    mutable std::mutex m_mutex;
+    std::vector<xmlParserCtxtPtr> m_idle { };
+    std::size_t m_capacity;
+
+public:
+
+    explicit XMLParserPool (std::size_t capacity = 4);
+    ~XMLParserPool ();
+
+    XMLParserPool (const XMLParserPool &) = delete;
+    XMLParserPool & operator = (const XMLParserPool &) = delete;
+
+    xmlParserCtxtPtr acquire ();
+    void release (xmlParserCtxtPtr ctxt);
+
+    std::size_t capacity () const
+    {
+        return m_capacity;
+    }
+
+    std::size_t idle () const;
+
+    static XMLParserPool & thread_pool ();
+
+};          // class XMLParserPool
+
+}           // namespace xml66
+
+#endif      // XML66_XML_XML66POOL_HPP
+
+/*
+ * xml66pool.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,152 @@
+#if ! defined XML66_XML_XML66QUERY_HPP
+#define XML66_XML_XML66QUERY_HPP
+
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66query.hpp
+ *
+ *    Provides compiled XPath queries and a cache of them.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ *
+ *  An XMLQuery holds an expression compiled both by libxml2, for queries
+ *  against a kept xmlDoc, and by XMLXPath, for queries against XMLNode
+ *  trees (if the expression is in its subset).  Applications can compile
+ *  the queries they repeat once and pass them to XMLTree::find().
+ *
+ *  XMLTree::find() with a string looks the expression up in the tree's
+ *  XMLQueryCache, which keeps the most recently used queries.  The cache
+ *  is locked by a mutex, so const trees can still be queried from several
+ *  threads.  Queries are shared, immutable, and returned by shared_ptr, so
+ *  a query stays valid after the cache drops it.
+ */
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <libxml/xpath.h>
+
+#include "xml/xml66xpath.hpp"           /* xml66::XMLXPath native XPath     */
+
+namespace xml66
+{
+
+/**
+ * XMLQuery
+ */
+
+class XMLQuery
+{
+
+private:
+
+    std::string m_text;
+    std::unique_ptr<XMLXPath> m_native;
+    xmlXPathCompExprPtr m_compiled;
+
+public:
+
+    explicit XMLQuery (const std::string & xpath);
+    ~XMLQuery ();
+
+    XMLQuery (const XMLQuery &) = delete;
+    XMLQuery & operator = (const XMLQuery &) = delete;
+
+    const std::string & text () const
+    {
+        return m_text;
+    }
+
+    /**
+     *  The native form, or null if the expression needs libxml2.
+     */
+
+    const XMLXPath * native () const
+    {
+        return m_native.get();
+    }
+
+    xmlXPathCompExprPtr compiled () const
+    {
+        return m_compiled;
+    }
+
+};          // class XMLQuery
+
+using XMLQueryPtr = std::shared_ptr<const XMLQuery>;
+
+/**
+ * XMLQueryCache
+ */
+
+class XMLQueryCache
+{
+
+private:
+
+    using query_list = std::list<XMLQueryPtr>;
+
+    /*
+     * The queries, most recently used first, and an index into the list
+     * by the text of each query (which the query owns).
+     */
+
+    mutable std::mutex m_mutex;
+    query_list m_queries { };
+    std::unordered_map<std::string_view, query_list::iterator> m_index { };
+    std::size_t m_capacity;
+
+public:
+
+    explicit XMLQueryCache (std::size_t capacity = 32);
+
+    XMLQueryCache (const XMLQueryCache &) = delete;
+    XMLQueryCache & operator = (const XMLQueryCache &) = delete;
+
+    XMLQueryPtr get (const std::string & xpath);
+    void set_capacity (std::size_t capacity);
+    std::size_t capacity () const;
+    std::size_t size () const;
+    void clear ();
+
+private:
+
+    void trim ();
+
+};          // class XMLQueryCache
+
+}           // namespace xml66
+
+#endif      // XML66_XML_XML66QUERY_HPP
+
+/*
+ * xml66query.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,150 @@
+#if ! defined XML66_XML_XML66STREAM_HPP
+#define XML66_XML_XML66STREAM_HPP
+
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66stream.hpp
+ *
+ *    Provides XPath queries evaluated while a file is read.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ *
+ *  XMLTree::find() needs the whole tree in memory.  An XMLStream instead
+ *  reads the file with an xmlTextReader and hands back the nodes that an
+ *  expression selects one at a time, as next() reaches them, without ever
+ *  building the rest of the document.  For example:
+ *
+ *      XMLStream s
+ *      {
+ *          "big.ardour",
+ *          "/Session/Sources/Source[contains(@captured-for,'Guitar')]"
+ *      };
+ *      while (XMLNodePtr source = s.next())
+ *          use(*source);
+ *
+ *  The expression must be XMLXPath::streamable():  an absolute path of
+ *  child and descendant steps, with predicates that test only attributes
+ *  of the node (not its position or its content), optionally ending in an
+ *  attribute step.  Each node is then decided when its start tag is read.
+ *  Subtrees that no step can reach are skipped unread.
+ *
+ *  Only a selected element is built, with its subtree, so memory is
+ *  bounded by the depth of the document and the largest subtree selected,
+ *  not by the size of the file.  The results are the copies that
+ *  XMLTree::find() would return, in the same (document) order.  An
+ *  element selected inside another selected element is returned after it.
+ */
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <libxml/xmlreader.h>
+
+#include "xml/xml66xpath.hpp"           /* xml66::XMLXPath native XPath     */
+#include "xml/xml66xx.hpp"              /* xml66::XMLNode, XMLNodePtr       */
+
+namespace xml66
+{
+
+/**
+ * XMLStream
+ */
+
+class XMLStream
+{
+
+private:
+
+    /**
+     *  An open element:  the states for its children and, inside a
+     *  selected subtree, the node being built for it.
+     */
+
+    struct frame
+    {
+        XMLXPath::matcher::states states;
+        XMLNode * node;
+    };
+
+    std::string m_filename;
+    std::unique_ptr<XMLXPath> m_xpath;
+    XMLXPath::matcher m_matcher;
+    xmlTextReaderPtr m_reader;
+    std::vector<frame> m_frames;
+    XMLNode * m_capture;                /* the selected subtree being built */
+    std::vector<const XMLNode *> m_nested;  /* selected nodes in m_capture  */
+    std::deque<XMLNodePtr> m_ready;
+    bool m_skip;                        /* skip the current node's subtree  */
+    bool m_done;
+    bool m_good;
+
+public:
+
+    XMLStream (const std::string & filename, const std::string & xpath);
+    ~XMLStream ();
+
+    XMLStream (const XMLStream &) = delete;
+    XMLStream & operator = (const XMLStream &) = delete;
+
+    const std::string & filename () const
+    {
+        return m_filename;
+    }
+
+    /**
+     *  False if the file could not be opened or is not well-formed.  The
+     *  nodes returned before the error was found remain valid.
+     */
+
+    bool good () const
+    {
+        return m_good;
+    }
+
+    XMLNodePtr next ();
+
+    static XMLNode * read_node (xmlTextReaderPtr reader);
+
+private:
+
+    void read ();
+    void element ();
+    void content ();
+    void end_element ();
+    void finish (XMLNode * node);
+    void release ();
+
+};          // class XMLStream
+
+}           // namespace xml66
+
+#endif      // XML66_XML_XML66STREAM_HPP
+
+/*
+ * xml66stream.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
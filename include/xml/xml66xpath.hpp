@@ -0,0 +1,254 @@
+#if ! defined XML66_XML_XML66XPATH_HPP
+#define XML66_XML_XML66XPATH_HPP
+
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66xpath.hpp
+ *
+ *    Provides XPath evaluation directly on an XMLNode tree.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ *
+ *  XMLTree::find() used to evaluate every query with libxml2, which for an
+ *  XMLNode subtree meant writing the subtree into a new xmlDoc first.
+ *  XMLXPath compiles an XPath 1.0 expression once and evaluates it on the
+ *  XMLNode tree itself.  It supports:
+ *
+ *      -   Absolute and relative location paths, '//', '.', and '..'.
+ *      -   The child, descendant, descendant-or-self, self, parent,
+ *          ancestor, ancestor-or-self, following-sibling,
+ *          preceding-sibling, and attribute axes, and '@'.
+ *      -   Name tests, '*', text(), and node().
+ *      -   Predicates, including numeric (positional) ones, and the
+ *          operators or, and, =, !=, <, <=, >, >=, +, -, *, div, mod, and
+ *          '|'.
+ *      -   The core functions last(), position(), count(), name(),
+ *          local-name(), string(), concat(), starts-with(), contains(),
+ *          substring-before(), substring-after(), substring(),
+ *          string-length(), normalize-space(), translate(), not(), true(),
+ *          false(), boolean(), number(), sum(), floor(), ceiling(), and
+ *          round().
+ *
+ *  compile() returns null for anything else (namespace prefixes,
+ *  variables, other axes or functions, filter expressions), and the
+ *  caller then uses libxml2.
+ *
+ *  Numbers are converted to and from strings exactly as libxml2 does it,
+ *  not as XPath 1.0 specifies:  "1e3" is 1000, and string(1e20) is
+ *  "1e+20", so the two engines agree on every query.
+ *
+ *  The tree is seen the way XMLTree::find() has always seen a subtree:  the
+ *  given node is the document element, and every content node (text,
+ *  CDATA, or comment) is a text node.
+ *
+ *  A plain absolute path of element names, each with at most one
+ *  attribute-equality predicate (e.g. "/rosegarden-data/studio/device" or
+ *  "/Session/Sources/Source[@id='1234']"), is planned as a simple path.
+ *  select() walks it child by child, using the child index of large nodes
+ *  and any XMLIndex given, without the general evaluator.
+ *
+ *  A forward path whose predicates test only attributes is streamable():
+ *  XMLXPath::matcher can then decide each node as soon as its start tag is
+ *  read, which XMLStream uses to query files without loading them.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "xml/xml66index.hpp"           /* xml66::XMLIndex, XMLIndexList    */
+
+namespace xml66
+{
+
+class XMLNode;
+class XMLProperty;
+
+/**
+ * XMLXPath
+ */
+
+class XMLXPath
+{
+
+public:
+
+    /**
+     *  A node selected by an expression.  For an attribute, node is its
+     *  element and property is the attribute; otherwise property is null.
+     *  The document node, selected by "/", has both null.
+     */
+
+    struct hit
+    {
+        const XMLNode * node;
+        const XMLProperty * property;
+    };
+
+    using hit_list = std::vector<hit>;
+
+    /**
+     *  A step of a simple path:  a child element name and, if attribute is
+     *  not empty, the value the attribute must have.
+     */
+
+    struct path_step
+    {
+        XMLName name;
+        XMLName attribute;
+        std::string value;
+    };
+
+    using path = std::vector<path_step>;
+
+    /*
+     * The parsed expression, defined in the implementation.
+     */
+
+    struct expression;
+
+private:
+
+    std::string m_text;
+    std::unique_ptr<expression> m_expression;
+    path m_path;                        /* empty if not a simple path       */
+    bool m_forward;                     /* select_many() can batch it       */
+    bool m_streamable;                  /* XMLStream can evaluate it        */
+
+    XMLXPath (const std::string & text, std::unique_ptr<expression> expr);
+
+public:
+
+    ~XMLXPath ();
+
+    XMLXPath (const XMLXPath &) = delete;
+    XMLXPath & operator = (const XMLXPath &) = delete;
+
+    static std::unique_ptr<XMLXPath> compile (const std::string & xpath);
+
+    const std::string & text () const
+    {
+        return m_text;
+    }
+
+    /**
+     *  True if the expression is a simple path, which select() walks.
+     */
+
+    bool simple () const
+    {
+        return ! m_path.empty();
+    }
+
+    const path & steps () const
+    {
+        return m_path;
+    }
+
+    /**
+     *  True if select_many() evaluates the expression in its shared pass:
+     *  an absolute path of child and descendant steps with no positional
+     *  predicates, possibly ending in an attribute step.
+     */
+
+    bool forward () const
+    {
+        return m_forward;
+    }
+
+    /**
+     *  True if XMLStream can evaluate the expression as a document is read:
+     *  a forward() path whose predicates use only the attributes of the
+     *  node they test.
+     */
+
+    bool streamable () const
+    {
+        return m_streamable;
+    }
+
+    /**
+     *  Follows a streamable() expression through a document one node at a
+     *  time, in document order, for XMLStream.  A state is the index of a
+     *  step that the next node may match.
+     */
+
+    class matcher
+    {
+
+    public:
+
+        using states = std::vector<std::size_t>;
+
+    private:
+
+        const XMLXPath & m_xpath;
+
+    public:
+
+        explicit matcher (const XMLXPath & xpath);
+
+        /**
+         *  The states of the document element.
+         */
+
+        states start () const
+        {
+            return states { 0 };
+        }
+
+        hit_list step
+        (
+            const XMLNode & node, const states & active, states & next
+        ) const;
+
+    };          // class XMLXPath::matcher
+
+    hit_list select
+    (
+        const XMLNode & root, const XMLIndexList * indexes = nullptr
+    ) const;
+    bool uses_index (const XMLIndexList & indexes) const;
+
+    static std::vector<hit_list> select_many
+    (
+        const std::vector<const XMLXPath *> & xpaths, const XMLNode & root
+    );
+
+private:
+
+    hit_list walk (const XMLNode & root, const XMLIndexList * indexes) const;
+
+};          // class XMLXPath
+
+}           // namespace xml66
+
+#endif      // XML66_XML_XML66XPATH_HPP
+
+/*
+ * xml66xpath.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
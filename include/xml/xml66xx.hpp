@@ -59,15 +59,24 @@
  * \library       xml66 library
  * \author        Chris Ahlstrom
  * \date          2026-02-20
- * \updates       2026-02-23
+ * \updates       2026-10-16
  * \version       $Revision$
  *
  */
 
+#include <atomic>
 #include <cstdarg>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <deque>
+#include <iterator>                     /* std::forward_iterator_tag        */
 #include <memory>
+#include <mutex>
+#include <new>                          /* std::launder()                   */
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <utility>                      /* std::as_const()                  */
 #include <vector>
 
@@ -75,6 +84,13 @@
 #include <libxml/tree.h>
 
 #include "c_macros.h"                   /* lib66's is_nullptr() etc. macros */
+#include "xml/xml66arena.hpp"           /* xml66::XMLArena node allocation  */
+#include "xml/xml66frozen.hpp"          /* xml66::XMLFrozenTree class       */
+#include "xml/xml66index.hpp"           /* xml66::XMLIndex, XMLIndexList    */
+#include "xml/xml66name.hpp"            /* xml66::XMLName interned names    */
+#include "xml/xml66pool.hpp"            /* xml66::XMLParserPool class       */
+#include "xml/xml66query.hpp"           /* xml66::XMLQuery, XMLQueryCache   */
+#include "xml/xml66xpath.hpp"           /* xml66::XMLXPath native XPath     */
 #include "util/strconversions.hpp"      /* util::to_string<> templates      */
 
 namespace xml66
@@ -83,6 +99,131 @@ namespace xml66
 class XMLTree;
 class XMLNode;
 
+/**
+ *  Tracks the changes made to the nodes of one XMLTree through the setters
+ *  of XMLNode and XMLProperty.  Each node of a tree points to the tree's
+ *  XMLEdits, which counts each change, so that the tree can tell whether
+ *  its xmlDoc still matches its nodes, and passes it on to the tree, which
+ *  patches what it has built from the nodes.  Changes to nodes outside
+ *  any tree are not tracked.
+ *
+ *  Nodes built while a tree reads a document are made inside its scope,
+ *  which gives them the tree and is not counted.  Copies are made inside
+ *  a quiet scope.
+ */
+
+class XMLEdits
+{
+
+    friend class XMLTree;
+
+public:
+
+    /**
+     *  Stops tracking on this thread for the lifetime of the scope.
+     */
+
+    class quiet
+    {
+
+    public:
+
+        quiet ()
+        {
+            ++s_quiet;
+        }
+
+        ~quiet ()
+        {
+            --s_quiet;
+        }
+
+        quiet (const quiet &) = delete;
+        quiet & operator = (const quiet &) = delete;
+
+    };          // class quiet
+
+    /**
+     *  Makes the nodes constructed on this thread, for the lifetime of the
+     *  scope, part of a tree, without tracking the changes made to them.
+     */
+
+    class scope
+    {
+
+    private:
+
+        XMLEdits * m_prior;
+        quiet m_quiet;
+
+    public:
+
+        explicit scope (XMLEdits * edits) :
+            m_prior (s_current),
+            m_quiet ()
+        {
+            s_current = edits;
+        }
+
+        ~scope ()
+        {
+            s_current = m_prior;
+        }
+
+        scope (const scope &) = delete;
+        scope & operator = (const scope &) = delete;
+
+    };          // class scope
+
+private:
+
+    XMLTree & m_tree;
+    std::atomic<std::uint64_t> m_count { 0 };
+    static thread_local int s_quiet;
+    static thread_local XMLEdits * s_current;
+
+public:
+
+    explicit XMLEdits (XMLTree & tree) :
+        m_tree  (tree)
+    {
+        // No code
+    }
+
+    XMLEdits (const XMLEdits &) = delete;
+    XMLEdits & operator = (const XMLEdits &) = delete;
+
+    std::uint64_t count () const
+    {
+        return m_count.load(std::memory_order_acquire);
+    }
+
+    static XMLEdits * current ()
+    {
+        return s_current;
+    }
+
+    /**
+     *  True if changes to a node with these edits are to be reported.
+     */
+
+    static bool tracked (const XMLEdits * edits)
+    {
+        return not_nullptr(edits) && s_quiet == 0;
+    }
+
+    void property
+    (
+        XMLNode & node, XMLName name,
+        const std::string * before, const std::string * after
+    );
+    void content (XMLNode & node);
+    void added (XMLNode & parent, XMLNode & child);
+    void removing (XMLNode & parent, XMLNode & child);
+    void replaced (XMLNode & node);
+
+};          // class XMLEdits
+
 /**
  * XMLProperty
  */
@@ -90,11 +231,20 @@ class XMLNode;
 class XMLProperty
 {
 
+    friend class XMLNode;
+
 private:
 
-    std::string m_name { };
+    XMLName m_name { };
     std::string m_value { };
 
+    /*
+     * The node holding this property, which reports its changes.  Copies
+     * of a property belong to no node.
+     */
+
+    XMLNode * m_owner { nullptr };
+
 public:
 
     XMLProperty () = delete;
@@ -110,9 +260,49 @@ public:
         // No code
     }
 
+    XMLProperty (XMLName n, const std::string & v) :
+        m_name  (n),
+        m_value (v)
+    {
+        // No code
+    }
+
+    XMLProperty (const XMLProperty & other) :
+        m_name  (other.m_name),
+        m_value (other.m_value)
+    {
+        // No code
+    }
+
+    XMLProperty (XMLProperty && other) noexcept :
+        m_name  (other.m_name),
+        m_value (std::move(other.m_value))
+    {
+        // No code
+    }
+
+    XMLProperty & operator = (const XMLProperty & other)
+    {
+        m_name = other.m_name;
+        m_value = other.m_value;
+        return *this;
+    }
+
+    XMLProperty & operator = (XMLProperty && other) noexcept
+    {
+        m_name = other.m_name;
+        m_value = std::move(other.m_value);
+        return *this;
+    }
+
     ~XMLProperty () = default;
 
     const std::string & name () const
+    {
+        return m_name.str();
+    }
+
+    XMLName atom () const
     {
         return m_name;
     }
@@ -122,12 +312,186 @@ public:
         return m_value;
     }
 
-    const std::string & set_value (const std::string & v)
+    const std::string & set_value (const std::string & v);
+
+};          // class XMLProperty
+
+/**
+ *  XMLPropertyList holds the properties of an XMLNode by value.  The first
+ *  few share one block, allocated with the first property (from the
+ *  current XMLArena, if any), and the rest go in a deque, so no property
+ *  ever moves.  A node without properties, such as a text node, pays only
+ *  for the empty list.
+ *
+ *  The slots in use are linked in the order the properties were added.
+ *  Erasing a property unlinks its slot and puts it on a free list, from
+ *  which the next push_back() takes it, so an edited node does not grow,
+ *  and iteration never visits erased slots.  Pointers to the other
+ *  properties, as returned by XMLNode::property(), stay valid.
+ *
+ *  Iterators yield XMLProperty pointers, like the std::vector of pointers
+ *  this replaces.
+ */
+
+class XMLPropertyList
+{
+
+public:
+
+    static constexpr std::size_t c_block_count { 4 };
+
+private:
+
+    using index_type = std::uint32_t;
+
+    static constexpr index_type c_none { index_type(-1) };
+
+    struct slot
+    {
+        XMLProperty property;
+        index_type next;                /* next in order, or in free list   */
+
+        slot (XMLName n, const std::string & v) :
+            property    (n, v),
+            next        (c_none)
+        {
+            // No code
+        }
+    };
+
+    using overflow_list = std::deque<slot>;
+
+public:
+
+    class iterator
+    {
+
+        friend class XMLPropertyList;
+
+    public:
+
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = XMLProperty *;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = XMLProperty * const *;
+        using reference         = XMLProperty *;
+
+    private:
+
+        const XMLPropertyList * m_list;
+        index_type m_index;
+        index_type m_prior;             /* the slot linked before, for erase */
+
+        iterator
+        (
+            const XMLPropertyList * list, index_type index,
+            index_type prior = c_none
+        ) :
+            m_list  (list),
+            m_index (index),
+            m_prior (prior)
+        {
+            // No code
+        }
+
+    public:
+
+        XMLProperty * operator * () const
+        {
+            return &m_list->at(m_index).property;
+        }
+
+        iterator & operator ++ ()
+        {
+            m_prior = m_index;
+            m_index = m_list->at(m_index).next;
+            return *this;
+        }
+
+        iterator operator ++ (int)
+        {
+            iterator result { *this };
+            ++*this;
+            return result;
+        }
+
+        bool operator == (const iterator & rhs) const
+        {
+            return m_index == rhs.m_index;
+        }
+
+        bool operator != (const iterator & rhs) const
+        {
+            return m_index != rhs.m_index;
+        }
+
+    };          // class iterator
+
+    using const_iterator = iterator;
+
+private:
+
+    slot * m_block { nullptr };         /* the first c_block_count slots    */
+    std::unique_ptr<overflow_list> m_overflow { };
+    index_type m_used { 0 };            /* slots constructed, live or free  */
+    index_type m_live { 0 };
+    index_type m_head { c_none };
+    index_type m_tail { c_none };
+    index_type m_free { c_none };
+    bool m_block_in_arena { false };
+
+public:
+
+    XMLPropertyList () = default;
+    XMLPropertyList (const XMLPropertyList &) = delete;
+    XMLPropertyList & operator = (const XMLPropertyList &) = delete;
+    XMLPropertyList (XMLPropertyList && from);
+    XMLPropertyList & operator = (XMLPropertyList && from);
+
+    ~XMLPropertyList ()
+    {
+        clear();
+    }
+
+    iterator begin () const
     {
-        return m_value = v;
+        return iterator(this, m_head);
     }
 
-};          // class XMLProperty
+    iterator end () const
+    {
+        return iterator(this, c_none);
+    }
+
+    std::size_t size () const
+    {
+        return m_live;
+    }
+
+    bool empty () const
+    {
+        return m_live == 0;
+    }
+
+    XMLProperty * push_back
+    (
+        XMLName name, const std::string & value, XMLArena * arena = nullptr
+    );
+    iterator erase (iterator pos);
+    void clear ();
+    bool holds_heap () const;
+
+private:
+
+    slot & at (index_type index) const
+    {
+        if (index < c_block_count)
+            return m_block[index];
+
+        return (*m_overflow)[index - c_block_count];
+    }
+
+};          // class XMLPropertyList
 
 /**
  *  Type aliases.
@@ -139,9 +503,24 @@ using XMLSharedNodeList         = std::vector<XMLNodePtr>;
 using SharedNodeListPtr         = std::shared_ptr<XMLSharedNodeList>;
 using XMLNodeIterator           = XMLNodeList::iterator;
 using XMLNodeConstIterator      = XMLNodeList::const_iterator;
-using XMLPropertyList           = std::vector<XMLProperty *>;
 using XMLPropertyIterator       = XMLPropertyList::iterator;
 using XMLPropertyConstIterator  = XMLPropertyList::const_iterator;
+using XMLTreePtr                = std::shared_ptr<XMLTree>;
+using XMLTreeList               = std::vector<XMLTreePtr>;
+
+/**
+ *  A node selected by XMLTree::find_nodes(), in the tree itself.  For an
+ *  attribute, node is its element and property the attribute; otherwise
+ *  property is null.
+ */
+
+struct XMLNodeRef
+{
+    XMLNode * node;
+    XMLProperty * property;
+};
+
+using XMLNodeRefList            = std::vector<XMLNodeRef>;
 
 /**
  * XMLTree
@@ -150,6 +529,61 @@ using XMLPropertyConstIterator  = XMLPropertyList::const_iterator;
 class XMLTree
 {
 
+public:
+
+    /**
+     *  Selects how read() turns a file into the XMLNode tree.
+     *
+     *  -   document. libxml2 parses the whole file into an xmlDoc, which is
+     *      then converted to XMLNode objects. The xmlDoc is kept for use by
+     *      find().
+     *  -   streaming. An xmlTextReader walks the file and the XMLNode tree
+     *      is built directly from the reader events. No xmlDoc is kept, so
+     *      the document is held in memory only once. Validation always
+     *      uses the document mode.
+     *  -   lazy. Like document, but each XMLNode converts its properties
+     *      and children from the xmlDoc only when they are first accessed.
+     *      The xmlDoc must outlive the nodes, so nodes detached from the
+     *      tree are fully converted first. Not safe for concurrent readers
+     *      until XMLNode::materialize() has been called on the root.
+     *  -   native. The in-tree XMLParser builds the XMLNode tree directly,
+     *      without libxml2 and without keeping an xmlDoc.  Documents it
+     *      cannot handle are read in the streaming mode instead, as is
+     *      everything if the library was built without the 'native-parser'
+     *      option.
+     */
+
+    enum class ingest
+    {
+        document,
+        streaming,
+        lazy,
+        native
+    };
+
+    /**
+     *  How find() evaluates a query, as reported by explain():
+     *
+     *  -   walk. A simple path (see XMLXPath), followed child by child
+     *      through the XMLNode tree.
+     *  -   index. XMLXPath, answering at least one step from an index made
+     *      by build_index().
+     *  -   native. XMLXPath, evaluating the expression on the XMLNode tree.
+     *  -   document. libxml2, on the kept xmlDoc.
+     *  -   libxml. libxml2, on the nodes written into an xmlDoc.
+     *  -   none. Nothing; the tree is empty.
+     */
+
+    enum class plan
+    {
+        walk,
+        index,
+        native,
+        document,
+        libxml,
+        none
+    };
+
 private:
 
     std::string m_filename { };
@@ -157,21 +591,107 @@ private:
     xmlDocPtr   m_doc { nullptr };
     int         m_compression { 0 };
 
+    /*
+     * The pool that parser contexts are borrowed from.  If null, the
+     * calling thread's XMLParserPool::thread_pool() is used.
+     */
+
+    XMLParserPool * m_pool { nullptr };
+
+    /*
+     * In arena mode, the nodes and properties built by a read are taken
+     * from m_arena, which is released when the tree is read again or
+     * destroyed.  Nodes read into the tree must not outlive it.
+     */
+
+    bool        m_use_arena { false };
+    std::unique_ptr<XMLArena> m_arena { };
+
+    /*
+     * The push parser between begin() and finish(), the last child of the
+     * root element already converted to an XMLNode, and whether finish()
+     * keeps the xmlDoc.
+     */
+
+    xmlParserCtxtPtr m_push { nullptr };
+    xmlNodePtr  m_push_last { nullptr };
+    bool        m_push_keep_doc { false };
+
+    /*
+     * Bytes ending in '<' or '\r' at the end of a chunk, held back for the
+     * next one.  libxml2's blank heuristics need the character after them.
+     */
+
+    std::string m_push_held { };
+    ingest      m_ingest { ingest::document };
+
+    /*
+     * Files at least this large are memory-mapped and parsed from memory
+     * instead of through the buffered I/O of libxml2.  Zero disables it.
+     */
+
+    std::size_t m_mmap_threshold { 64 * 1024 };
+
+    /*
+     * The recently used queries of find(), compiled.
+     */
+
+    mutable XMLQueryCache m_queries { };
+
+    /*
+     * The changes made to the nodes of this tree, and their count when
+     * m_doc was read.  Once a node has been changed, m_doc no longer
+     * matches m_root, and find() uses m_root.  For queries that need
+     * libxml2, m_root is then written into an xmlDoc, kept in m_query_doc
+     * and patched as the nodes change.
+     */
+
+    struct query_doc;
+
+    XMLEdits    m_edits { *this };
+    std::uint64_t m_doc_edits { 0 };
+    mutable std::mutex m_query_doc_mutex;
+    mutable std::shared_ptr<query_doc> m_query_doc { };
+
+    /*
+     * The (element, attribute) pairs given to build_index(), and their
+     * indexes of m_root, which are patched as the nodes change.
+     */
+
+    std::vector<std::pair<XMLName, XMLName>> m_index_keys { };
+    mutable std::mutex m_index_mutex;
+    mutable std::shared_ptr<XMLIndexList> m_indexes { };
+
 public:
 
     XMLTree () = default;
     XMLTree (const std::string & fn, bool validate = false);
+    XMLTree (const std::string & fn, ingest mode);
     XMLTree (const XMLTree *);
     ~XMLTree ();
 
+    static XMLTreeList load_all
+    (
+        const std::vector<std::string> & paths,
+        unsigned threads = 0,
+        ingest mode = ingest::document
+    );
+
     XMLNode * root () const
     {
         return m_root;
     }
 
-    XMLNode * set_root (XMLNode * n)
+    XMLNode * set_root (XMLNode * n);
+
+    /**
+     *  True if the tree has a kept xmlDoc and none of its nodes has been
+     *  changed since it was read.
+     */
+
+    bool doc_current () const
     {
-        return m_root = n;
+        return not_nullptr(m_doc) && m_doc_edits == m_edits.count();
     }
 
     const std::string & filename () const
@@ -191,6 +711,55 @@ public:
 
     int set_compression (int);
 
+    ingest ingest_mode () const
+    {
+        return m_ingest;
+    }
+
+    void set_ingest_mode (ingest mode)
+    {
+        m_ingest = mode;
+    }
+
+    std::size_t mmap_threshold () const
+    {
+        return m_mmap_threshold;
+    }
+
+    void set_mmap_threshold (std::size_t bytes)
+    {
+        m_mmap_threshold = bytes;
+    }
+
+    XMLParserPool & parser_pool () const
+    {
+        return not_nullptr(m_pool) ? *m_pool : XMLParserPool::thread_pool();
+    }
+
+    void set_parser_pool (XMLParserPool * pool)
+    {
+        m_pool = pool;
+    }
+
+    bool arena_mode () const
+    {
+        return m_use_arena;
+    }
+
+    /*
+     *  Takes effect at the next read.
+     */
+
+    void set_arena_mode (bool on)
+    {
+        m_use_arena = on;
+    }
+
+    const XMLArena * arena () const
+    {
+        return m_arena.get();
+    }
+
     bool read ()
     {
         return read_internal(false);
@@ -214,6 +783,26 @@ public:
     }
 
     bool read_buffer (char const *, bool to_tree_doc = false);
+    bool read_buffer_n
+    (
+        char const * buffer, std::size_t len, bool to_tree_doc = false
+    );
+
+    bool read_buffer (std::string_view buffer, bool to_tree_doc = false)
+    {
+        return read_buffer_n(buffer.data(), buffer.size(), to_tree_doc);
+    }
+
+    bool begin (bool to_tree_doc = false);
+    bool feed (const char * chunk, std::size_t len);
+
+    bool feed (std::string_view chunk)
+    {
+        return feed(chunk.data(), chunk.size());
+    }
+
+    bool finish ();
+
     bool write () const;
 
     bool write (const std::string & fn)
@@ -224,6 +813,7 @@ public:
 
     void debug (FILE *) const;
     const std::string & write_buffer () const;
+    XMLFrozenTree freeze () const;
 
     // TODO use alias
 
@@ -232,12 +822,247 @@ public:
         const std::string xpath, XMLNode * = nullptr
     ) const;
 
+    SharedNodeListPtr find
+    (
+        const XMLQuery & query, XMLNode * = nullptr
+    ) const;
+
+    std::vector<SharedNodeListPtr> find_many
+    (
+        const std::vector<std::string> & xpaths, XMLNode * node = nullptr
+    ) const;
+
+    XMLNodeRefList find_nodes
+    (
+        const std::string & xpath, XMLNode * node = nullptr
+    ) const
+    {
+        return find_nodes(*query(xpath), node);
+    }
+
+    XMLNodeRefList find_nodes
+    (
+        const XMLQuery & query, XMLNode * = nullptr
+    ) const;
+
+    /**
+     *  The compiled form of an expression, from the query cache.
+     */
+
+    XMLQueryPtr query (const std::string & xpath) const
+    {
+        return m_queries.get(xpath);
+    }
+
+    XMLQueryCache & query_cache ()
+    {
+        return m_queries;
+    }
+
+    bool build_index
+    (
+        const std::string & element, const std::string & attribute
+    );
+    void drop_indexes ();
+
+    plan explain (const std::string & xpath, XMLNode * node = nullptr) const
+    {
+        return explain(*query(xpath), node);
+    }
+
+    plan explain (const XMLQuery & query, XMLNode * node = nullptr) const;
+    static const char * plan_name (plan p);
+
 private:
 
     bool read_internal (bool validate);
+    bool read_streaming ();
+    bool read_native (const char * buffer, std::size_t len);
+    void push_convert (xmlNodePtr root, xmlNodePtr upto);
+    void push_reset ();
+    void clear_root ();
+    static void release_nodes (XMLNode * root);
+    std::shared_ptr<const query_doc> root_doc () const;
+    void drop_caches ();
+    query_doc * patchable_doc ();
+    XMLIndexList * patchable_indexes () const;
+    std::shared_ptr<const XMLIndexList> indexes () const;
+
+    /*
+     * The changes reported by m_edits.
+     */
+
+    friend class XMLEdits;
+
+    void property_edited
+    (
+        XMLNode & node, XMLName name,
+        const std::string * before, const std::string * after
+    );
+    void content_edited (XMLNode & node);
+    void child_added (XMLNode & parent, XMLNode & child);
+    void child_removing (XMLNode & child);
+    void node_replaced (XMLNode & node);
+    plan choose
+    (
+        const XMLQuery & query, const XMLNode * node,
+        const XMLIndexList * built
+    ) const;
+
+    static SharedNodeListPtr find_native
+    (
+        const XMLXPath & xpath, const XMLNode & node,
+        const XMLIndexList * indexes = nullptr
+    );
+    static SharedNodeListPtr copy_hits
+    (
+        const XMLXPath::hit_list & hits, const XMLNode & node
+    );
+
+    static void push_end_element
+    (
+        void * ctx, const xmlChar * localname,
+        const xmlChar * prefix, const xmlChar * uri
+    );
 
 };          // class XMLTree
 
+/**
+ *  A view of the children of a node that satisfy a predicate.  Iterating
+ *  it neither copies the child list nor changes the node, so any number of
+ *  threads can iterate the children of a shared tree.  The view is valid
+ *  until the children of the node are changed.
+ */
+
+template <class Pred>
+class XMLChildRange
+{
+
+public:
+
+    class iterator
+    {
+
+    public:
+
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = XMLNode *;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = XMLNode * const *;
+        using reference         = XMLNode *;
+
+    private:
+
+        XMLNodeConstIterator m_pos;
+        XMLNodeConstIterator m_end;
+        const Pred * m_pred;
+
+        void skip ()
+        {
+            while (m_pos != m_end && ! (*m_pred)(*m_pos))
+                ++m_pos;
+        }
+
+    public:
+
+        iterator
+        (
+            XMLNodeConstIterator pos, XMLNodeConstIterator end,
+            const Pred * pred
+        ) :
+            m_pos   (pos),
+            m_end   (end),
+            m_pred  (pred)
+        {
+            skip();
+        }
+
+        XMLNode * operator * () const
+        {
+            return *m_pos;
+        }
+
+        iterator & operator ++ ()
+        {
+            ++m_pos;
+            skip();
+            return *this;
+        }
+
+        iterator operator ++ (int)
+        {
+            iterator result { *this };
+            ++*this;
+            return result;
+        }
+
+        bool operator == (const iterator & rhs) const
+        {
+            return m_pos == rhs.m_pos;
+        }
+
+        bool operator != (const iterator & rhs) const
+        {
+            return m_pos != rhs.m_pos;
+        }
+
+    };          // class iterator
+
+private:
+
+    XMLNodeConstIterator m_begin;
+    XMLNodeConstIterator m_end;
+    Pred m_pred;
+
+public:
+
+    XMLChildRange
+    (
+        XMLNodeConstIterator b, XMLNodeConstIterator e, Pred pred
+    ) :
+        m_begin (b),
+        m_end   (e),
+        m_pred  (std::move(pred))
+    {
+        // No code
+    }
+
+    iterator begin () const
+    {
+        return iterator(m_begin, m_end, &m_pred);
+    }
+
+    iterator end () const
+    {
+        return iterator(m_end, m_end, &m_pred);
+    }
+
+    bool empty () const
+    {
+        return begin() == end();
+    }
+
+    /**
+     *  The first match, or null.
+     */
+
+    XMLNode * front () const
+    {
+        iterator it { begin() };
+        return it != end() ? *it : nullptr;
+    }
+
+    std::size_t size () const
+    {
+        std::size_t result { 0 };
+        for (iterator it { begin() }; it != end(); ++it)
+            ++result;
+
+        return result;
+    }
+
+};          // class XMLChildRange
+
 /**
  * XMLNode
  */
@@ -245,28 +1070,164 @@ private:
 class XMLNode
 {
 
+public:
+
+    /**
+     *  Nodes with at least this many children build an index of them by
+     *  name on the first child() or children(name) call.  Smaller nodes
+     *  are scanned instead.
+     */
+
+    static constexpr std::size_t c_child_index_threshold { 16 };
+
+    /**
+     *  The predicate of children_named().
+     */
+
+    class name_match
+    {
+
+    private:
+
+        XMLName m_atom;
+
+    public:
+
+        explicit name_match (XMLName atom) : m_atom (atom)
+        {
+            // No code
+        }
+
+        bool operator () (const XMLNode * n) const
+        {
+            return n->m_name == m_atom;
+        }
+
+    };          // class name_match
+
 private:
 
-    std::string         m_name { };
+    /*
+     * The children grouped by name, plus the names they had when indexed.
+     * A child renamed by assignment cannot tell its parent, so assignment
+     * bumps s_rename_epoch, and a lookup through an index with an older
+     * epoch first checks the names.  An index replaced while other threads
+     * may still read it is kept as "retired" until the index is dropped.
+     */
+
+    struct child_index
+    {
+        std::unordered_map<XMLName, XMLNodeList, XMLName::hasher> lists { };
+        std::vector<XMLName> names { };
+        std::atomic<std::uint64_t> epoch { 0 };
+        std::unique_ptr<child_index> retired { };
+    };
+
+    static std::atomic<std::uint64_t> s_rename_epoch;
+
+    XMLName             m_name { };
     bool                m_is_content { false };
     std::string         m_content { };
     XMLNodeList         m_children { };
     XMLPropertyList     m_proplist { };
-    mutable XMLNodeList m_selected_children { };
+
+    /*
+     * The children grouped by name, in document order, built on demand.
+     * A const lookup builds a complete index and then publishes it with a
+     * compare-and-swap, so several threads may look up children of the
+     * same node at once; a thread that loses the race discards its copy.
+     * Appending a child updates the index and removing children drops it,
+     * and those, like all changes (including renaming a child), need
+     * exclusive access to the node.
+     */
+
+    mutable std::atomic<child_index *> m_child_index { nullptr };
+
+    /*
+     * For XMLTree::ingest::lazy, the libxml2 node whose properties and/or
+     * children have not yet been converted.
+     */
+
+    mutable xmlNodePtr  m_source { nullptr };
+    mutable bool        m_lazy_properties { false };
+    mutable bool        m_lazy_children { false };
+
+    /*
+     * True if operator new took this node from an XMLArena.
+     */
+
+    bool                m_in_arena { XMLArena::claim(this) };
+
+    /*
+     * The changes of the tree this node is part of, or null.  All nodes
+     * of a subtree share it; see join().
+     */
+
+    XMLEdits *          m_edits { XMLEdits::current() };
+
+    /*
+     * The readers, which append checked attributes with
+     * add_property_nocheck(), and XMLProperty, which reports its changes.
+     */
+
+    friend class XMLFrozenNode;
+    friend class XMLProperty;
+    friend class XMLParser;
+    friend class XMLStream;
+    friend class XMLTree;
+    friend XMLNode * readelement (xmlNodePtr node);
+
+    explicit XMLNode (xmlNodePtr source);
+
+    bool holds_heap () const;
+
+    /**
+     *  The arena to take this node's property block from:  the current
+     *  one, but only if the node was itself allocated there.
+     */
+
+    XMLArena * own_arena () const
+    {
+        return m_in_arena ? XMLArena::current() : nullptr;
+    }
+
+    void add_property_nocheck (const char * name, const std::string & value);
+    void add_property_nocheck (XMLName name, const std::string & value);
+    void join (XMLEdits * edits);
+    void adopt (XMLNode & child);
+    void disown (XMLNode & child);
 
 public:
 
     XMLNode () = delete;
     XMLNode (const std::string & name);
+    explicit XMLNode (XMLName name);
     XMLNode (const std::string & name, const std::string & content);
-    XMLNode (const XMLNode & other);                // TODO &&
-    XMLNode & operator = (const XMLNode & other);   // TODO &&
+    XMLNode (const XMLNode & other);
+    XMLNode (XMLNode && other);
+    XMLNode & operator = (const XMLNode & other);
+    XMLNode & operator = (XMLNode && other);
     ~XMLNode ();
 
+    static void * operator new (std::size_t bytes)
+    {
+        return XMLArena::allocate_object(bytes);
+    }
+
+    static void operator delete (void * p)
+    {
+        XMLArena::deallocate_object(p);
+    }
+
     bool operator == (const XMLNode & other) const;
     bool operator != (const XMLNode & other) const;
 
     const std::string & name () const
+    {
+        return m_name.str();
+    }
+
+    XMLName atom () const
     {
         return m_name;
     }
@@ -285,16 +1246,60 @@ public:
     XMLNode * add_content (const std::string & s = "");
 
     const std::string & child_content() const;
-    const XMLNodeList & children (const std::string & str = "") const;
+
+    const XMLNodeList & children () const
+    {
+        need_children();
+        return m_children;
+    }
+
+    XMLNodeList children (const std::string & name) const;
+    XMLChildRange<name_match> children_named (std::string_view name) const;
+
+    /**
+     *  Iterates over the children for which pred(const XMLNode *) is true,
+     *  without copying them.
+     */
+
+    template <class Pred>
+    XMLChildRange<Pred> children_where (Pred pred) const
+    {
+        need_children();
+        return XMLChildRange<Pred>
+        (
+            m_children.begin(), m_children.end(), std::move(pred)
+        );
+    }
     XMLNode * child (const char *) const;
     XMLNode * add_child (const char *);
+    XMLNode * add_child (XMLNode && n);
     XMLNode * add_child_copy (const XMLNode &);
     void add_child_nocopy (XMLNode &);
 
+    /**
+     *  Constructs a child in place from XMLNode constructor arguments, such
+     *  as a name, or a name and content.
+     *
+     * \return
+     *      Returns the new child, owned by this node.
+     */
+
+    template <class... Args>
+    XMLNode * emplace_child (Args &&... args)
+    {
+        need_children();
+        XMLNode * child { new XMLNode(std::forward<Args>(args)...) };
+        m_children.push_back(child);
+        index_child(child);
+        adopt(*child);
+        return child;
+    }
+
     std::string attribute_value ();  // throws XMLException if it doesn't exist
 
     const XMLPropertyList & properties () const
     {
+        need_properties();
         return m_proplist;
     }
 
@@ -394,10 +1399,48 @@ public:
     );
 
     void dump (std::ostream &, const std::string & p = "") const;
+    void materialize () const;
 
 private:
 
     void clear_lists ();
+    const XMLNodeList * indexed_children (XMLName atom, bool build) const;
+    bool index_matches (const child_index & index) const;
+    child_index * publish_child_index
+    (
+        child_index * stale, std::uint64_t epoch
+    ) const;
+    void rename (XMLName name);
+
+    void index_child (XMLNode * child)
+    {
+        child_index * index { m_child_index.load(std::memory_order_relaxed) };
+        if (not_nullptr(index))
+        {
+            index->lists[child->m_name].push_back(child);
+            index->names.push_back(child->m_name);
+        }
+    }
+
+    void drop_child_index ()
+    {
+        delete m_child_index.exchange(nullptr);
+    }
+
+    void need_properties () const
+    {
+        if (m_lazy_properties)
+            load_properties();
+    }
+
+    void need_children () const
+    {
+        if (m_lazy_children)
+            load_children();
+    }
+
+    void load_properties () const;
+    void load_children () const;
 
 };          // class XMLNode
 
@@ -0,0 +1,177 @@
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66arena.cpp
+ *
+ *    Provides a monotonic arena for the XMLNode and XMLProperty objects of
+ *    an XMLTree.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ */
+
+#include <new>                          /* ::operator new(), delete         */
+
+#include "c_macros.h"                   /* lib66's is_nullptr() etc. macros */
+#include "xml/xml66arena.hpp"           /* xml66::XMLArena class            */
+
+namespace xml66
+{
+
+/**
+ *  The arena of the calling thread, set by XMLArena::scope.
+ */
+
+static thread_local XMLArena * s_current_arena { nullptr };
+
+/**
+ *  The last object allocated from an arena by this thread and not yet
+ *  claimed by its constructor, and the last arena object destroyed by this
+ *  thread and not yet passed to operator delete.
+ */
+
+static thread_local const void * s_unclaimed { nullptr };
+static thread_local const void * s_destroyed { nullptr };
+
+XMLArena::scope::scope (XMLArena * arena) :
+    m_prior (s_current_arena)
+{
+    s_current_arena = arena;
+}
+
+XMLArena::scope::~scope ()
+{
+    s_current_arena = m_prior;
+}
+
+/**
+ * \param initial_size
+ *      The size of the first block taken from the heap.  Later blocks grow
+ *      geometrically.  No memory is taken until the first allocation.
+ */
+
+XMLArena::XMLArena (std::size_t initial_size) :
+    m_resource  (initial_size),
+    m_bytes     (0)
+{
+    // No code
+}
+
+void *
+XMLArena::allocate (std::size_t bytes, std::size_t alignment)
+{
+    m_bytes += bytes;
+    return m_resource.allocate(bytes, alignment);
+}
+
+/**
+ *  Returns all of the arena's memory to the heap.  Every object allocated
+ *  from it must already have been destroyed.
+ */
+
+void
+XMLArena::release ()
+{
+    m_resource.release();
+    m_bytes = 0;
+}
+
+XMLArena *
+XMLArena::current ()
+{
+    return s_current_arena;
+}
+
+/**
+ *  The operator new of the arena-aware classes.  Without a current arena
+ *  this is just the global operator new.  The constructor of an object
+ *  taken from the arena must claim() it.
+ */
+
+void *
+XMLArena::allocate_object (std::size_t bytes)
+{
+    XMLArena * arena { s_current_arena };
+    if (is_nullptr(arena))
+        return ::operator new(bytes);
+
+    void * result { arena->allocate(bytes, alignof(std::max_align_t)) };
+    s_unclaimed = result;
+    return result;
+}
+
+/**
+ *  The operator delete of the arena-aware classes.  Memory of an object
+ *  just reported by destroyed(), or of one whose constructor threw before
+ *  claiming it, belongs to an arena, and is reclaimed only by release().
+ */
+
+void
+XMLArena::deallocate_object (void * p)
+{
+    if (is_nullptr(p))
+        return;
+
+    if (p == s_destroyed)
+        s_destroyed = nullptr;
+    else if (p == s_unclaimed)
+        s_unclaimed = nullptr;
+    else
+        ::operator delete(p);
+}
+
+/**
+ *  Called by a constructor with its own address.
+ *
+ * \return
+ *      Returns true if the object was just allocated from an arena by
+ *      allocate_object().
+ */
+
+bool
+XMLArena::claim (const void * object)
+{
+    if (object != s_unclaimed || is_nullptr(object))
+        return false;
+
+    s_unclaimed = nullptr;
+    return true;
+}
+
+/**
+ *  Called at the end of the destructor of an object that claim() reported
+ *  as coming from an arena, just before operator delete is given it.
+ */
+
+void
+XMLArena::destroyed (const void * object)
+{
+    s_destroyed = object;
+}
+
+}           // namespace xml66
+
+/*
+ * xml66arena.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,252 @@
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66frozen.cpp
+ *
+ *    Provides a compact, read-only copy of an XMLNode tree.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ */
+
+#include "xml/xml66frozen.hpp"          /* xml66::XMLFrozenTree class       */
+#include "xml/xml66xx.hpp"              /* xml66::XMLNode, XMLException     */
+
+namespace xml66
+{
+
+/**
+ * Class: XMLFrozenNode
+ */
+
+/**
+ *  Returns the content of the first content child, like
+ *  XMLNode::child_content().
+ */
+
+std::string_view
+XMLFrozenNode::child_content () const
+{
+    for (auto n : children())
+    {
+        if (n.is_content())
+            return n.content();
+    }
+    return std::string_view();
+}
+
+/**
+ *  Returns the first child with the given name, or an invalid handle.
+ */
+
+XMLFrozenNode
+XMLFrozenNode::child (const char * name) const
+{
+    XMLName atom;
+    if (not_nullptr(name) && XMLName::find(name, atom))
+    {
+        for (auto n : children())
+        {
+            if (n.atom() == atom)
+                return n;
+        }
+    }
+    return XMLFrozenNode(m_tree, c_none);
+}
+
+bool
+XMLFrozenNode::has_property (const char * name) const
+{
+    std::string unused;
+    return get_property(name, unused);
+}
+
+bool
+XMLFrozenNode::get_property (const char * name, std::string & value) const
+{
+    XMLName atom;
+    if (is_nullptr(name) || ! XMLName::find(name, atom))
+        return false;
+
+    for (auto prop : properties())
+    {
+        if (prop.atom() == atom)
+        {
+            value = prop.value();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+XMLFrozenNode::has_property_with_value
+(
+    const std::string & name,
+    const std::string & value
+) const
+{
+    XMLName atom;
+    if (! XMLName::find(name, atom))
+        return false;
+
+    for (auto prop : properties())
+    {
+        if (prop.atom() == atom && prop.value() == value)
+            return true;
+    }
+    return false;
+}
+
+/**
+ *  Copies this node and its descendants back into a new, mutable XMLNode
+ *  tree, which the caller owns.
+ */
+
+XMLNode *
+XMLFrozenNode::thaw () const
+{
+    XMLEdits::quiet thawing;            /* a new tree is not an edit        */
+    XMLNode * result { new XMLNode(atom()) };
+    if (is_content())
+        (void) result->set_content(std::string(content()));
+
+    for (auto prop : properties())
+        result->add_property_nocheck(prop.atom(), std::string(prop.value()));
+
+    for (auto n : children())
+        result->add_child_nocopy(*n.thaw());
+
+    return result;
+}
+
+/**
+ * Class: XMLFrozenTree
+ */
+
+/**
+ *  Copies an XMLNode tree.  Lazy nodes are converted as they are visited.
+ *
+ * \throw
+ *      Throws XMLException if the tree has four billion or more nodes or
+ *      bytes of text, which the 32-bit indices cannot hold.
+ */
+
+XMLFrozenTree::XMLFrozenTree (const XMLNode & root)
+{
+    (void) freeze(root, XMLFrozenNode::c_none);
+    if (m_prop_names.size() >= XMLFrozenNode::c_none)
+        throw XMLException("XMLFrozenTree: too many properties");
+
+    m_prop_begin.push_back(index(m_prop_names.size()));
+    m_names.shrink_to_fit();                /* the arrays never grow again  */
+    m_parent.shrink_to_fit();
+    m_first_child.shrink_to_fit();
+    m_next_sibling.shrink_to_fit();
+    m_prop_begin.shrink_to_fit();
+    m_prop_names.shrink_to_fit();
+    m_prop_values.shrink_to_fit();
+    m_content.shrink_to_fit();
+    m_is_content.shrink_to_fit();
+    m_pool.shrink_to_fit();
+}
+
+/**
+ *  Adds a node in depth-first order, then its children.
+ *
+ * \return
+ *      Returns the index of the node.
+ */
+
+XMLFrozenTree::index
+XMLFrozenTree::freeze (const XMLNode & n, index parent)
+{
+    if (m_names.size() >= XMLFrozenNode::c_none)
+        throw XMLException("XMLFrozenTree: too many nodes");
+
+    index result { index(m_names.size()) };
+    m_names.push_back(n.atom());
+    m_parent.push_back(parent);
+    m_first_child.push_back(XMLFrozenNode::c_none);
+    m_next_sibling.push_back(XMLFrozenNode::c_none);
+    m_prop_begin.push_back(index(m_prop_names.size()));
+    for (auto prop : n.properties())
+    {
+        m_prop_names.push_back(prop->atom());
+        m_prop_values.push_back(add_text(prop->value()));
+    }
+    m_content.push_back(add_text(n.content()));
+    m_is_content.push_back(n.is_content());
+
+    index previous { XMLFrozenNode::c_none };
+    for (auto child : n.children())
+    {
+        index c { freeze(*child, result) };
+        if (previous == XMLFrozenNode::c_none)
+            m_first_child[result] = c;
+        else
+            m_next_sibling[previous] = c;
+
+        previous = c;
+    }
+    return result;
+}
+
+XMLFrozenTree::text_range
+XMLFrozenTree::add_text (const std::string & s)
+{
+    if (m_pool.size() + s.size() >= XMLFrozenNode::c_none)
+        throw XMLException("XMLFrozenTree: too much text");
+
+    text_range result { index(m_pool.size()), index(s.size()) };
+    m_pool += s;
+    return result;
+}
+
+/**
+ *  The bytes used by the arrays and the string pool, not counting the
+ *  shared name table.
+ */
+
+std::size_t
+XMLFrozenTree::memory_bytes () const
+{
+    return
+        m_names.capacity() * sizeof(XMLName) +
+        m_parent.capacity() * sizeof(index) +
+        m_first_child.capacity() * sizeof(index) +
+        m_next_sibling.capacity() * sizeof(index) +
+        m_prop_begin.capacity() * sizeof(index) +
+        m_prop_names.capacity() * sizeof(XMLName) +
+        m_prop_values.capacity() * sizeof(text_range) +
+        m_content.capacity() * sizeof(text_range) +
+        m_is_content.capacity() / 8 +
+        m_pool.capacity();
+}
+
+}           // namespace xml66
+
+/*
+ * xml66frozen.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,248 @@
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66index.cpp
+ *
+ *    Provides an index of elements by the value of one attribute.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ */
+
+#include <algorithm>                    /* std::lower_bound()               */
+
+#include "c_macros.h"                   /* lib66's not_nullptr() etc.       */
+#include "xml/xml66index.hpp"           /* xml66::XMLIndex class            */
+#include "xml/xml66xx.hpp"              /* xml66::XMLNode class             */
+
+namespace xml66
+{
+
+/**
+ * Class: XMLIndex
+ */
+
+XMLIndex::XMLIndex (XMLName element, XMLName attribute) :
+    m_element   (element),
+    m_attribute (attribute)
+{
+    // No code
+}
+
+/**
+ *  Replaces the entries with those of the tree under the given root.
+ *  Elements are visited in document order, so each list of entries is in
+ *  document order.  Lazy nodes are converted as they are visited.
+ */
+
+void
+XMLIndex::build (const XMLNode & root)
+{
+    m_entries.clear();
+    m_elements.clear();
+    m_size = 0;
+    m_stale = false;
+    add(root, nullptr);
+}
+
+/**
+ * \return
+ *      Returns the elements whose attribute has the value, which is an
+ *      empty list if there are none.
+ */
+
+const XMLIndex::entry_list &
+XMLIndex::lookup (const std::string & value) const
+{
+    static const entry_list s_none;
+    auto it { m_entries.find(value) };
+    return it != m_entries.end() ? it->second : s_none;
+}
+
+/**
+ *  Moves the entry of an element whose indexed attribute was added,
+ *  changed, or removed.
+ *
+ * \param before
+ *      The old value, or null if the attribute was added.
+ *
+ * \param after
+ *      The new value, or null if the attribute was removed.
+ */
+
+void
+XMLIndex::update
+(
+    const XMLNode & node,
+    const std::string * before, const std::string * after
+)
+{
+    if (m_stale)
+        return;
+
+    auto it { m_elements.find(&node) };
+    if (it == m_elements.end())
+    {
+        m_stale = true;                 /* not seen when built              */
+        return;
+    }
+    if (not_nullptr(before))
+        erase(*before, it->second);
+
+    if (not_nullptr(after))
+        insert(*after, it->second);
+}
+
+/**
+ *  Notes a subtree appended to the tree.  Its elements of the indexed name
+ *  would need a place in document order, which is not known, so the index
+ *  becomes stale if there are any.  Other elements do not matter.
+ */
+
+void
+XMLIndex::added (const XMLNode & subtree)
+{
+    if (m_stale || subtree.is_content())
+        return;
+
+    if (subtree.atom() == m_element)
+    {
+        m_stale = true;
+        return;
+    }
+    for (auto child : subtree.children())
+        added(*child);
+}
+
+/**
+ *  Drops the entries of the elements of a subtree about to be removed.
+ *  The other entries keep their order.
+ */
+
+void
+XMLIndex::removing (const XMLNode & subtree)
+{
+    if (m_stale || subtree.is_content())
+        return;
+
+    if (subtree.atom() == m_element)
+    {
+        auto it { m_elements.find(&subtree) };
+        if (it != m_elements.end())
+        {
+            for (auto prop : subtree.properties())
+            {
+                if (prop->atom() == m_attribute)
+                {
+                    erase(prop->value(), it->second);
+                    break;
+                }
+            }
+            m_elements.erase(it);
+        }
+    }
+    for (auto child : subtree.children())
+        removing(*child);
+}
+
+void
+XMLIndex::add (const XMLNode & node, const XMLNode * parent)
+{
+    if (node.is_content())
+        return;
+
+    if (node.atom() == m_element)
+    {
+        entry e { &node, parent, m_elements.size() };
+        m_elements.emplace(&node, e);
+        for (auto prop : node.properties())
+        {
+            if (prop->atom() == m_attribute)
+            {
+                m_entries[prop->value()].push_back(e);
+                ++m_size;
+                break;
+            }
+        }
+    }
+    for (auto child : node.children())
+        add(*child, &node);
+}
+
+/**
+ *  Adds an entry to the list for a value, in document order.
+ */
+
+void
+XMLIndex::insert (const std::string & value, const entry & e)
+{
+    entry_list & list { m_entries[value] };
+    auto pos
+    {
+        std::lower_bound
+        (
+            list.begin(), list.end(), e,
+            [] (const entry & lhs, const entry & rhs)
+            {
+                return lhs.order < rhs.order;
+            }
+        )
+    };
+    (void) list.insert(pos, e);
+    ++m_size;
+}
+
+void
+XMLIndex::erase (const std::string & value, const entry & e)
+{
+    auto it { m_entries.find(value) };
+    if (it == m_entries.end())
+        return;
+
+    entry_list & list { it->second };
+    auto pos
+    {
+        std::lower_bound
+        (
+            list.begin(), list.end(), e,
+            [] (const entry & lhs, const entry & rhs)
+            {
+                return lhs.order < rhs.order;
+            }
+        )
+    };
+    if (pos != list.end() && pos->node == e.node)
+    {
+        (void) list.erase(pos);
+        --m_size;
+        if (list.empty())
+            m_entries.erase(it);
+    }
+}
+
+}           // namespace xml66
+
+/*
+ * xml66index.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,186 @@
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66name.cpp
+ *
+ *    Provides interned element and attribute names.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ */
+
+#include <deque>                        /* std::deque<>, stable elements    */
+#include <mutex>                        /* std::unique_lock<>               */
+#include <shared_mutex>                 /* std::shared_mutex                */
+#include <unordered_map>                /* std::unordered_map<>             */
+
+#include "xml/xml66name.hpp"            /* xml66::XMLName class             */
+
+namespace xml66
+{
+
+namespace
+{
+
+using name_map = std::unordered_map<std::string_view, const std::string *>;
+
+/**
+ *  The shared table.  The deque never moves its strings, so the views used
+ *  as keys and the pointers handed out stay valid.  It is never destroyed,
+ *  so names remain usable by static objects during program exit.
+ */
+
+class name_table
+{
+
+private:
+
+    std::shared_mutex m_mutex;
+    std::deque<std::string> m_strings;
+    name_map m_map;
+
+public:
+
+    name_table () : m_mutex (), m_strings (), m_map ()
+    {
+        // No code
+    }
+
+    const std::string * find (std::string_view name)
+    {
+        std::shared_lock<std::shared_mutex> lock { m_mutex };
+        auto it { m_map.find(name) };
+        return it != m_map.end() ? it->second : nullptr;
+    }
+
+    const std::string * intern (std::string_view name)
+    {
+        const std::string * result { find(name) };
+        if (result == nullptr)
+        {
+            std::unique_lock<std::shared_mutex> lock { m_mutex };
+            auto it { m_map.find(name) };       /* another thread's add?    */
+            if (it != m_map.end())
+                return it->second;
+
+            m_strings.emplace_back(name);
+            result = &m_strings.back();
+            m_map.emplace(std::string_view(*result), result);
+        }
+        return result;
+    }
+
+    std::size_t size ()
+    {
+        std::shared_lock<std::shared_mutex> lock { m_mutex };
+        return m_map.size();
+    }
+
+};          // class name_table
+
+name_table &
+table ()
+{
+    static name_table * s_table { new name_table };
+    return *s_table;
+}
+
+/**
+ *  The names this thread has already interned.  The keys view strings in
+ *  the shared table, which live forever.
+ */
+
+name_map &
+cache ()
+{
+    static thread_local name_map s_cache;
+    return s_cache;
+}
+
+const std::string *
+intern (std::string_view name)
+{
+    name_map & local { cache() };
+    auto it { local.find(name) };
+    if (it != local.end())
+        return it->second;
+
+    const std::string * result { table().intern(name) };
+    local.emplace(std::string_view(*result), result);
+    return result;
+}
+
+}           // namespace anonymous
+
+/**
+ *  The empty name, which is also used for CDATA sections.
+ */
+
+XMLName::XMLName () : m_atom (nullptr)
+{
+    static const std::string * const s_empty { intern(std::string_view()) };
+    m_atom = s_empty;
+}
+
+XMLName::XMLName (std::string_view name) : m_atom (intern(name))
+{
+    // No code
+}
+
+/**
+ *  Looks up a name without adding it.  Since every node and property name
+ *  is interned, a name not in the table is not the name of anything, and
+ *  a search for it can stop at once.
+ *
+ * \return
+ *      Returns true if the name was found, and sets the result.
+ */
+
+bool
+XMLName::find (std::string_view name, XMLName & result)
+{
+    name_map & local { cache() };
+    auto it { local.find(name) };
+    const std::string * atom
+    {
+        it != local.end() ? it->second : table().find(name)
+    };
+    if (atom == nullptr)
+        return false;
+
+    result.m_atom = atom;
+    return true;
+}
+
+std::size_t
+XMLName::table_size ()
+{
+    return table().size();
+}
+
+}           // namespace xml66
+
+/*
+ * xml66name.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
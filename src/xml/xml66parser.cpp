@@ -0,0 +1,1342 @@
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66parser.cpp
+ *
+ *    Provides a small native XML parser that builds the XMLNode tree
+ *    directly, without libxml2.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ *
+ *  The scanning of text and attribute values, which is where nearly all of
+ *  the bytes of a document go, looks at 16 bytes at a time with SSE2 when
+ *  the compiler targets it (always the case for x86-64), and otherwise
+ *  falls back to plain loops.
+ */
+
+#include <cstring>                      /* std::memcmp()                    */
+
+#include "c_macros.h"                   /* lib66's is_nullptr() etc. macros */
+#include "utfcpp/utf8.h"                /* utf8::simd::is_valid(), append() */
+#include "xml/xml66parser.hpp"          /* xml66::XMLParser class           */
+#include "xml/xml66xx.hpp"              /* xml66::XMLNode class             */
+
+#if defined __SSE2__
+#include <emmintrin.h>
+#define XML66_PARSER_SSE2
+#endif
+
+namespace xml66
+{
+
+/*
+ * Character classification and scanning helpers.
+ */
+
+static inline bool
+is_blank (char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+static inline bool
+is_name_end (char c)
+{
+    return is_blank(c) || c == '>' || c == '/' || c == '=' || c == '?' ||
+        c == '<' || c == '"' || c == '\'' || c == '&';
+}
+
+static inline bool
+starts_with (const char * p, const char * end, const char * s)
+{
+    std::size_t n { std::strlen(s) };
+    return std::size_t(end - p) >= n && std::memcmp(p, s, n) == 0;
+}
+
+/**
+ *  Returns a pointer to the first non-blank character, or end.
+ */
+
+static inline const char *
+skip_blanks (const char * p, const char * end)
+{
+#if defined XML66_PARSER_SSE2
+    const __m128i sp { _mm_set1_epi8(' ') };
+    const __m128i nl { _mm_set1_epi8('\n') };
+    const __m128i tab { _mm_set1_epi8('\t') };
+    const __m128i cr { _mm_set1_epi8('\r') };
+    while (end - p >= 16)
+    {
+        __m128i x { _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)) };
+        __m128i m
+        {
+            _mm_or_si128
+            (
+                _mm_or_si128(_mm_cmpeq_epi8(x, sp), _mm_cmpeq_epi8(x, nl)),
+                _mm_or_si128(_mm_cmpeq_epi8(x, tab), _mm_cmpeq_epi8(x, cr))
+            )
+        };
+        unsigned bits { unsigned(~_mm_movemask_epi8(m)) & 0xFFFFu };
+        if (bits != 0)
+            return p + __builtin_ctz(bits);
+
+        p += 16;
+    }
+#endif
+    while (p < end && is_blank(*p))
+        ++p;
+
+    return p;
+}
+
+/**
+ *  Returns a pointer to the first '<' or '&' in character data, or to the
+ *  first byte that libxml2 does not handle in its fast ASCII path:  a
+ *  non-ASCII byte, or a control character other than tab and newline
+ *  (which includes the carriage return).  Returns end if none is found.
+ */
+
+static inline const char *
+scan_text (const char * p, const char * end)
+{
+#if defined XML66_PARSER_SSE2
+    const __m128i lt { _mm_set1_epi8('<') };
+    const __m128i amp { _mm_set1_epi8('&') };
+    const __m128i tab { _mm_set1_epi8('\t') };
+    const __m128i nl { _mm_set1_epi8('\n') };
+    const __m128i ctl { _mm_set1_epi8(0x1f) };
+    while (end - p >= 16)
+    {
+        __m128i x { _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)) };
+        __m128i control
+        {
+            _mm_andnot_si128
+            (
+                _mm_or_si128(_mm_cmpeq_epi8(x, tab), _mm_cmpeq_epi8(x, nl)),
+                _mm_cmpeq_epi8(_mm_min_epu8(x, ctl), x)         /* <= 0x1f  */
+            )
+        };
+        __m128i m
+        {
+            _mm_or_si128
+            (
+                _mm_or_si128(_mm_cmpeq_epi8(x, lt), _mm_cmpeq_epi8(x, amp)),
+                control
+            )
+        };
+        unsigned bits
+        {
+            unsigned(_mm_movemask_epi8(m) | _mm_movemask_epi8(x))  /* 0x80+ */
+        };
+        if (bits != 0)
+            return p + __builtin_ctz(bits);
+
+        p += 16;
+    }
+#endif
+    while (p < end)
+    {
+        unsigned char c { (unsigned char)(*p) };
+        if (c == '<' || c == '&' || c >= 0x80)
+            break;
+
+        if (c < 0x20 && c != '\t' && c != '\n')
+            break;
+
+        ++p;
+    }
+    return p;
+}
+
+/**
+ *  Returns a pointer to the first '<' or '&', or end.
+ */
+
+static inline const char *
+scan_markup (const char * p, const char * end)
+{
+#if defined XML66_PARSER_SSE2
+    const __m128i lt { _mm_set1_epi8('<') };
+    const __m128i amp { _mm_set1_epi8('&') };
+    while (end - p >= 16)
+    {
+        __m128i x { _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)) };
+        __m128i m { _mm_or_si128(_mm_cmpeq_epi8(x, lt), _mm_cmpeq_epi8(x, amp)) };
+        unsigned bits { unsigned(_mm_movemask_epi8(m)) };
+        if (bits != 0)
+            return p + __builtin_ctz(bits);
+
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '<' && *p != '&')
+        ++p;
+
+    return p;
+}
+
+/**
+ *  Returns a pointer to the first quote, '&', '<', or control character
+ *  (which includes the blanks that get normalized) in an attribute value,
+ *  or end.
+ */
+
+static inline const char *
+scan_attribute (const char * p, const char * end, char quote)
+{
+#if defined XML66_PARSER_SSE2
+    const __m128i q { _mm_set1_epi8(quote) };
+    const __m128i amp { _mm_set1_epi8('&') };
+    const __m128i lt { _mm_set1_epi8('<') };
+    const __m128i ctl { _mm_set1_epi8(0x1f) };
+    while (end - p >= 16)
+    {
+        __m128i x { _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)) };
+        __m128i m
+        {
+            _mm_or_si128
+            (
+                _mm_or_si128(_mm_cmpeq_epi8(x, q), _mm_cmpeq_epi8(x, amp)),
+                _mm_or_si128
+                (
+                    _mm_cmpeq_epi8(x, lt),
+                    _mm_cmpeq_epi8(_mm_min_epu8(x, ctl), x)     /* <= 0x1f  */
+                )
+            )
+        };
+        unsigned bits { unsigned(_mm_movemask_epi8(m)) };
+        if (bits != 0)
+            return p + __builtin_ctz(bits);
+
+        p += 16;
+    }
+#endif
+    while (p < end)
+    {
+        char c { *p };
+        if (c == quote || c == '&' || c == '<' || (unsigned char)(c) <= 0x1f)
+            break;
+
+        ++p;
+    }
+    return p;
+}
+
+/**
+ *  Returns the start of the first occurrence of s, or end.
+ */
+
+static const char *
+find_string (const char * p, const char * end, const char * s)
+{
+    std::size_t n { std::strlen(s) };
+    while (std::size_t(end - p) >= n)
+    {
+        const void * c { std::memchr(p, s[0], std::size_t(end - p) - n + 1) };
+        if (is_nullptr(c))
+            break;
+
+        p = static_cast<const char *>(c);
+        if (std::memcmp(p, s, n) == 0)
+            return p;
+
+        ++p;
+    }
+    return end;
+}
+
+/**
+ *  The NameStartChar production of XML 1.0 (fifth edition), which libxml2
+ *  applies to element, attribute, and processing instruction names.
+ */
+
+static bool
+is_name_start_char (char32_t c)
+{
+    if (c < 0x80)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+            c == '_' || c == ':';
+    }
+    return (c >= 0xC0 && c <= 0xD6) || (c >= 0xD8 && c <= 0xF6) ||
+        (c >= 0xF8 && c <= 0x2FF) || (c >= 0x370 && c <= 0x37D) ||
+        (c >= 0x37F && c <= 0x1FFF) || (c >= 0x200C && c <= 0x200D) ||
+        (c >= 0x2070 && c <= 0x218F) || (c >= 0x2C00 && c <= 0x2FEF) ||
+        (c >= 0x3001 && c <= 0xD7FF) || (c >= 0xF900 && c <= 0xFDCF) ||
+        (c >= 0xFDF0 && c <= 0xFFFD) || (c >= 0x10000 && c <= 0xEFFFF);
+}
+
+/**
+ *  The NameChar production, which adds digits and a few combining
+ *  characters to NameStartChar.
+ */
+
+static bool
+is_name_char (char32_t c)
+{
+    if (is_name_start_char(c))
+        return true;
+
+    if (c < 0x80)
+        return (c >= '0' && c <= '9') || c == '-' || c == '.';
+
+    return c == 0xB7 || (c >= 0x300 && c <= 0x36F) ||
+        (c >= 0x203F && c <= 0x2040);
+}
+
+/**
+ *  Checks that the text, already known to be valid UTF-8, is an XML Name.
+ */
+
+static bool
+is_valid_name (const char * p, const char * end)
+{
+    bool first { true };
+    while (p < end)
+    {
+        char32_t c { char32_t((unsigned char)(*p)) };
+        if (c < 0x80)
+            ++p;
+        else
+            c = char32_t(utf8::unchecked::next(p));
+
+        if (first ? ! is_name_start_char(c) : ! is_name_char(c))
+            return false;
+
+        first = false;
+    }
+    return ! first;
+}
+
+/**
+ *  Checks comment, CDATA, and processing-instruction text for the control
+ *  characters that the XML Char production leaves out.
+ */
+
+static bool
+is_valid_text (const char * p, const char * end)
+{
+    for ( ; p < end; ++p)
+    {
+        if ((unsigned char)(*p) < 0x20 && ! is_blank(*p))
+            return false;
+    }
+    return true;
+}
+
+/**
+ *  Returns a pointer to the first U+FFFE or U+FFFF, which are valid UTF-8
+ *  but not XML characters, or end.
+ */
+
+static const char *
+find_nonchar (const char * p, const char * end)
+{
+    while (end - p >= 3)
+    {
+        const void * c { std::memchr(p, '\xEF', std::size_t(end - p) - 2) };
+        if (is_nullptr(c))
+            break;
+
+        p = static_cast<const char *>(c);
+        if (p[1] == '\xBF' && (p[2] == '\xBE' || p[2] == '\xBF'))
+            return p;
+
+        ++p;
+    }
+    return end;
+}
+
+/**
+ *  Appends text with libxml2's line-end normalization, which converts
+ *  "\r\n" and a lone "\r" to "\n".
+ */
+
+static void
+append_normalized (std::string & out, const char * p, const char * end)
+{
+    while (p < end)
+    {
+        const void * c { std::memchr(p, '\r', std::size_t(end - p)) };
+        const char * q { is_nullptr(c) ? end : static_cast<const char *>(c) };
+        out.append(p, q);
+        if (q == end)
+            break;
+
+        out += '\n';
+        p = q + 1;
+        if (p < end && *p == '\n')
+            ++p;
+    }
+}
+
+/**
+ * Class: XMLParser
+ */
+
+XMLParser::XMLParser (const char * text, std::size_t len) :
+    m_begin (text),
+    m_cur   (text),
+    m_end   (text + len)
+{
+    // no code
+}
+
+bool
+XMLParser::fail (const std::string & msg)
+{
+    if (m_error.empty())
+    {
+        m_error = msg + " at offset " + std::to_string(m_cur - m_begin);
+        if (not_nullptr(m_root))
+        {
+            delete m_root;
+            m_root = nullptr;
+        }
+        m_stack.clear();
+    }
+    return false;
+}
+
+/**
+ *  Parses the whole text.
+ *
+ * \return
+ *      Returns the root node, which the caller then owns, or nullptr if
+ *      the text is not well-formed or is outside of what this parser
+ *      supports.  See error_message().
+ */
+
+XMLNode *
+XMLParser::parse ()
+{
+    m_error.clear();
+    m_stack.clear();
+    m_prefixes.clear();
+    m_root = nullptr;
+    m_cur = m_begin;
+    if (starts_with(m_cur, m_end, "\xEF\xBB\xBF"))
+        m_cur += 3;
+
+    if (! utf8::simd::is_valid(m_cur, std::size_t(m_end - m_cur)))
+    {
+        (void) fail("invalid UTF-8");
+        return nullptr;
+    }
+
+    const char * nonchar { find_nonchar(m_cur, m_end) };
+    if (nonchar != m_end)
+    {
+        m_cur = nonchar;
+        (void) fail("character out of the allowed range");
+        return nullptr;
+    }
+    if (m_end - m_cur > 5 && starts_with(m_cur, m_end, "<?xml") &&
+        is_blank(m_cur[5]))
+    {
+        if (! parse_xml_decl())
+            return nullptr;
+    }
+    if (! skip_misc(true))
+        return nullptr;
+
+    if (m_cur == m_end || *m_cur != '<')
+    {
+        (void) fail("document has no root element");
+        return nullptr;
+    }
+    if (! parse_start_tag())
+        return nullptr;
+
+    while (! m_stack.empty())
+    {
+        if (! parse_text())
+            return nullptr;
+
+        if (m_cur == m_end)
+        {
+            (void) fail("premature end of document");
+            return nullptr;
+        }
+
+        bool ok { true };
+        if (starts_with(m_cur, m_end, "</"))
+        {
+            flush_text();
+            ok = parse_end_tag();
+        }
+        else if (starts_with(m_cur, m_end, "<!--"))
+        {
+            flush_text();
+            ok = parse_comment(m_value);
+            if (ok)
+            {
+                XMLNode * node { new XMLNode("comment") };
+                node->set_content(m_value);
+                add_node(node, false);
+            }
+        }
+        else if (starts_with(m_cur, m_end, "<![CDATA["))
+        {
+            flush_text();
+            ok = parse_cdata(m_value);
+            if (ok)
+            {
+                /*
+                 * libxml2 appends a CDATA section that directly follows
+                 * another one to that node.
+                 */
+
+                const XMLNodeList & kids { m_stack.back().node->children() };
+                XMLNode * last { kids.empty() ? nullptr : kids.back() };
+                if (not_nullptr(last) && last->name().empty())
+                {
+                    last->set_content(last->content() + m_value);
+                }
+                else
+                {
+                    XMLNode * node { new XMLNode("") };
+                    node->set_content(m_value);
+                    add_node(node, false);
+                }
+            }
+        }
+        else if (starts_with(m_cur, m_end, "<?"))
+        {
+            flush_text();
+            std::string target;
+            ok = parse_pi(target, m_value);
+            if (ok)
+            {
+                XMLNode * node { new XMLNode(target) };
+                node->set_content(m_value);
+                add_node(node, false);
+            }
+        }
+        else if (starts_with(m_cur, m_end, "<!"))
+        {
+            ok = fail("unexpected markup declaration");
+        }
+        else
+        {
+            flush_text();
+            ok = parse_start_tag();
+        }
+        if (! ok)
+            return nullptr;
+    }
+    if (! skip_misc(false) || m_cur != m_end)
+    {
+        (void) fail("extra content at the end of the document");
+        return nullptr;
+    }
+
+    XMLNode * result { m_root };
+    m_root = nullptr;
+    return result;
+}
+
+/**
+ *  Parses the XML declaration, with m_cur at the "<?xml".  The version is
+ *  required, and the encoding, if given, must be UTF-8 or its ASCII subset;
+ *  in the latter case the document must be pure ASCII.
+ */
+
+bool
+XMLParser::parse_xml_decl ()
+{
+    static const char * const s_names [] =
+    {
+        "version", "encoding", "standalone"
+    };
+    std::string values [3];
+    bool found [3] { false, false, false };
+    std::size_t next { 0 };
+    m_cur += 5;
+    for (;;)
+    {
+        const char * p { skip_blanks(m_cur, m_end) };
+        bool spaced { p != m_cur };
+        m_cur = p;
+        if (starts_with(m_cur, m_end, "?>"))
+        {
+            m_cur += 2;
+            break;
+        }
+        if (! spaced)
+            return fail("malformed XML declaration");
+
+        std::size_t i { next };
+        while (i < 3 && ! starts_with(m_cur, m_end, s_names[i]))
+            ++i;
+
+        if (i == 3)
+            return fail("malformed XML declaration");
+
+        m_cur = skip_blanks(m_cur + std::strlen(s_names[i]), m_end);
+        if (m_cur == m_end || *m_cur != '=')
+            return fail("'=' expected");
+
+        m_cur = skip_blanks(m_cur + 1, m_end);
+        if (m_cur == m_end || (*m_cur != '"' && *m_cur != '\''))
+            return fail("malformed XML declaration");
+
+        const char * q { static_cast<const char *>
+        (
+            std::memchr(m_cur + 1, *m_cur, std::size_t(m_end - m_cur - 1))
+        ) };
+        if (is_nullptr(q))
+            return fail("unterminated XML declaration");
+
+        values[i].assign(m_cur + 1, q);
+        found[i] = true;
+        next = i + 1;
+        m_cur = q + 1;
+    }
+    if (! found[0])
+        return fail("XML declaration without a version");
+
+    const std::string & version { values[0] };
+    std::size_t dot { version.find('.') };
+    if
+    (
+        dot == 0 || dot == std::string::npos || dot + 1 == version.size() ||
+        version.find_first_not_of("0123456789.") != std::string::npos ||
+        version.find('.', dot + 1) != std::string::npos
+    )
+    {
+        return fail("malformed version " + version);
+    }
+    if (found[1])
+    {
+        std::string name { values[1] };
+        for (auto & c : name)
+        {
+            if (c >= 'a' && c <= 'z')
+                c = char(c - 'a' + 'A');
+        }
+        if (name == "US-ASCII" || name == "ASCII")
+        {
+            for (const char * p = m_cur; p < m_end; ++p)
+            {
+                if ((unsigned char)(*p) >= 0x80)
+                {
+                    m_cur = p;
+                    return fail("non-ASCII character in an ASCII document");
+                }
+            }
+        }
+        else if (name != "UTF-8" && name != "UTF8")
+            return fail("unsupported encoding " + name);
+    }
+    if (found[2] && values[2] != "yes" && values[2] != "no")
+        return fail("malformed standalone declaration");
+
+    return true;
+}
+
+/**
+ *  Skips the blanks, comments, and processing instructions that can
+ *  precede or follow the root element.  Before it (in the prolog), one
+ *  document type declaration is skipped as well.
+ *
+ * \param prolog
+ *      True if the root element has not been parsed yet.
+ */
+
+bool
+XMLParser::skip_misc (bool prolog)
+{
+    bool doctype { false };
+    for (;;)
+    {
+        m_cur = skip_blanks(m_cur, m_end);
+        if (starts_with(m_cur, m_end, "<!--"))
+        {
+            if (! parse_comment(m_value))
+                return false;
+        }
+        else if (starts_with(m_cur, m_end, "<?"))
+        {
+            std::string target;
+            if (! parse_pi(target, m_value))
+                return false;
+        }
+        else if (prolog && starts_with(m_cur, m_end, "<!DOCTYPE"))
+        {
+            if (doctype)
+                return fail("more than one document type declaration");
+
+            if (! skip_doctype())
+                return false;
+
+            doctype = true;
+        }
+        else
+            break;
+    }
+    return true;
+}
+
+/**
+ *  Skips the document type declaration.  An internal subset can declare
+ *  entities and element content that change how libxml2 builds the tree,
+ *  so it is not supported.
+ */
+
+bool
+XMLParser::skip_doctype ()
+{
+    char quote { 0 };
+    for (const char * p = m_cur + 9; p < m_end; ++p)
+    {
+        char c { *p };
+        if (quote != 0)
+        {
+            if (c == quote)
+                quote = 0;
+        }
+        else if (c == '"' || c == '\'')
+            quote = c;
+        else if (c == '[')
+            return fail("internal DTD subsets are not supported");
+        else if (c == '>')
+        {
+            m_cur = p + 1;
+            return true;
+        }
+    }
+    return fail("unterminated document type declaration");
+}
+
+/**
+ *  Parses a start tag, with m_cur at the '<'.  The attributes are collected
+ *  first, since namespace declarations among them apply to the element and
+ *  to all of its attributes.  The new node is added to the current element
+ *  (or becomes the root) and, unless the tag is empty, becomes the current
+ *  element.
+ */
+
+bool
+XMLParser::parse_start_tag ()
+{
+    const char * name { ++m_cur };
+    while (m_cur < m_end && ! is_name_end(*m_cur))
+        ++m_cur;
+
+    if (! is_valid_name(name, m_cur))
+        return fail("invalid element name");
+
+    const char * name_end { m_cur };
+    std::size_t prefix_count { m_prefixes.size() };
+    int space { -1 };
+    if (! m_stack.empty() && m_stack.back().space != -2)
+        space = m_stack.back().space;
+
+    bool empty { false };
+    m_attribute_count = 0;
+    for (;;)
+    {
+        const char * p { skip_blanks(m_cur, m_end) };
+        bool spaced { p != m_cur };
+        m_cur = p;
+        if (m_cur == m_end)
+            return fail("unterminated start tag");
+
+        if (*m_cur == '>')
+        {
+            ++m_cur;
+            break;
+        }
+        if (starts_with(m_cur, m_end, "/>"))
+        {
+            m_cur += 2;
+            empty = true;
+            break;
+        }
+        if (! spaced)
+            return fail("attributes must be separated by blanks");
+
+        const char * aname { m_cur };
+        while (m_cur < m_end && ! is_name_end(*m_cur))
+            ++m_cur;
+
+        std::size_t alen { std::size_t(m_cur - aname) };
+        if (! is_valid_name(aname, m_cur))
+            return fail("invalid attribute name");
+
+        m_cur = skip_blanks(m_cur, m_end);
+        if (m_cur == m_end || *m_cur != '=')
+            return fail("'=' expected");
+
+        m_cur = skip_blanks(m_cur + 1, m_end);
+        if (m_attribute_count == m_attributes.size())
+            m_attributes.emplace_back();
+
+        attribute & attr { m_attributes[m_attribute_count++] };
+        attr.name = aname;
+        attr.length = alen;
+        if (! parse_attribute_value(attr.value))
+            return false;
+
+        for (std::size_t i = 0; i + 1 < m_attribute_count; ++i)
+        {
+            const attribute & other { m_attributes[i] };
+            if
+            (
+                other.length == alen &&
+                std::memcmp(other.name, aname, alen) == 0
+            )
+            {
+                return fail("attribute redefined");
+            }
+        }
+        if (alen > 6 && std::memcmp(aname, "xmlns:", 6) == 0)
+            m_prefixes.emplace_back(aname + 6, alen - 6);
+    }
+
+    XMLNode * node { new XMLNode(node_name(name, name_end)) };
+    if (m_stack.empty())
+    {
+        if (not_nullptr(m_root))
+        {
+            delete node;
+            return fail("extra content at the end of the document");
+        }
+        m_root = node;
+    }
+    else
+        add_node(node, false);
+
+    bool check { false };
+    for (std::size_t i = 0; i < m_attribute_count; ++i)
+    {
+        const attribute & attr { m_attributes[i] };
+        const char * aname { attr.name };
+        std::size_t alen { attr.length };
+        if
+        (
+            (alen == 5 && std::memcmp(aname, "xmlns", 5) == 0) ||
+            (alen > 6 && std::memcmp(aname, "xmlns:", 6) == 0)
+        )
+        {
+            continue;                   /* libxml2 keeps these elsewhere    */
+        }
+        if (alen == 9 && std::memcmp(aname, "xml:space", 9) == 0)
+        {
+            if (attr.value == "preserve")
+                space = 1;
+            else if (attr.value == "default")
+                space = 0;
+        }
+        if (std::memchr(aname, ':', alen) != nullptr)
+            check = true;                   /* see add_property_nocheck()   */
+
+        std::string pname { node_name(aname, aname + alen) };
+        if (check)
+            node->set_property(pname.c_str(), attr.value);
+        else
+            node->add_property_nocheck(pname.c_str(), attr.value);
+    }
+    if (empty)
+        m_prefixes.resize(prefix_count);
+    else
+    {
+        m_stack.push_back
+        (
+            level
+            {
+                node, name, std::size_t(name_end - name), prefix_count,
+                space, false, false
+            }
+        );
+    }
+    return true;
+}
+
+/**
+ *  Returns the name libxml2 gives to an element or attribute:  the local
+ *  part of a qualified name if its prefix is bound to a namespace, and the
+ *  whole qualified name otherwise.
+ */
+
+std::string
+XMLParser::node_name (const char * p, const char * end) const
+{
+    const void * c { std::memchr(p, ':', std::size_t(end - p)) };
+    if (not_nullptr(c))
+    {
+        const char * colon { static_cast<const char *>(c) };
+        std::size_t n { std::size_t(colon - p) };
+        bool bound { n == 3 && std::memcmp(p, "xml", 3) == 0 };
+        for (auto i = m_prefixes.rbegin(); ! bound && i != m_prefixes.rend(); ++i)
+            bound = i->size() == n && std::memcmp(i->data(), p, n) == 0;
+
+        if (bound)
+            p = colon + 1;
+    }
+    return std::string(p, end);
+}
+
+/**
+ *  Parses an end tag, with m_cur at the "</", and makes the parent element
+ *  the current one.
+ */
+
+bool
+XMLParser::parse_end_tag ()
+{
+    const level & top { m_stack.back() };
+    const char * name { m_cur + 2 };
+    const char * p { name };
+    while (p < m_end && ! is_name_end(*p))
+        ++p;
+
+    m_cur = p;
+    if
+    (
+        std::size_t(p - name) != top.qname_length ||
+        std::memcmp(name, top.qname, top.qname_length) != 0
+    )
+    {
+        return fail("mismatched end tag");
+    }
+    m_cur = skip_blanks(m_cur, m_end);
+    if (m_cur == m_end || *m_cur != '>')
+        return fail("'>' expected");
+
+    ++m_cur;
+    m_prefixes.resize(top.prefix_count);
+    m_stack.pop_back();
+    return true;
+}
+
+/**
+ *  Collects the character data up to the next '<' into m_text, leaving
+ *  out the blanks that libxml2 would report as ignorable whitespace.
+ *
+ *  libxml2 delivers character data in chunks, and its heuristic looks at
+ *  each chunk on its own.  In its fast path, a chunk is pure ASCII and
+ *  ends at a '<', a '&', or a "\r\n" pair (whose '\r' is dropped, so the
+ *  '\n' starts the next chunk, and further "\r\n" pairs right after it
+ *  stay in that chunk).  Anything else (non-ASCII, a lone '\r') switches to
+ *  its slow path up to the next '<' or '&'; that text is checked only if
+ *  it is all blanks.  References are always kept.
+ */
+
+bool
+XMLParser::parse_text ()
+{
+    const char * text { m_cur };
+    m_text.clear();
+    std::size_t lead { 0 };
+    bool after_crlf { false };
+    for (;;)
+    {
+        const char * p { m_cur };
+        const char * q { scan_text(p, m_end) };
+        char raw { q < m_end ? *q : char(0) };
+        char next { q + 1 < m_end ? q[1] : char(0) };
+        if (raw == '\r' && next == '\n')
+        {
+            if (after_crlf && q == p + 1)
+            {
+                ++lead;
+            }
+            else
+            {
+                add_chunk(lead, p, q, raw, next);
+                lead = 0;
+            }
+            after_crlf = true;
+            m_cur = q + 1;
+            continue;
+        }
+        bool slow { raw != 0 && raw != '<' && raw != '&' };
+        const char * start { q };
+        if (slow && after_crlf && q == p + 1)
+        {
+            start = p;                      /* the newlines go slow too */
+        }
+        else
+        {
+            add_chunk(lead, p, q, raw, next);
+            lead = 0;
+        }
+        after_crlf = false;
+        m_cur = q;
+        if (! slow && raw != '&')
+            break;
+
+        if (slow)
+        {
+            const char * r { scan_markup(q, m_end) };
+            for (const char * c = q; c < r; ++c)
+            {
+                unsigned char uc { (unsigned char)(*c) };
+                if (uc < 0x20 && ! is_blank(*c))
+                {
+                    m_cur = c;
+                    return fail("invalid character in text");
+                }
+            }
+            m_cur = r;
+            raw = r < m_end ? *r : char(0);
+            next = r + 1 < m_end ? r[1] : char(0);
+            bool blank
+            {
+                skip_blanks(start, r) == r &&
+                std::size_t(r - start) + lead < 300 && ignorable(raw, next)
+            };
+            if (! blank)
+            {
+                m_text.append(lead, '\n');
+                append_normalized(m_text, start, r);
+                level & top { m_stack.back() };
+                if (top.space == -1)
+                    top.space = -2;
+            }
+            lead = 0;
+            if (r == m_end || *r == '<')
+                break;
+        }
+        if (! parse_reference(m_text))
+            return false;
+    }
+
+    const char * cdata_end { find_string(text, m_cur, "]]>") };
+    if (cdata_end != m_cur)
+    {
+        m_cur = cdata_end;
+        return fail("']]>' in text");
+    }
+    return true;
+}
+
+/**
+ *  Handles one fast-path chunk of character data.  A chunk that starts
+ *  with a blank is dropped if it is all blanks and ignorable(); otherwise
+ *  it marks the element as holding mixed content, as libxml2 does.
+ *
+ * \param lead
+ *      The number of newlines merged into the front of the chunk from
+ *      consecutive "\r\n" pairs.
+ *
+ * \param raw
+ *      The character that ended the chunk.
+ *
+ * \param next
+ *      The character after that one.
+ */
+
+void
+XMLParser::add_chunk
+(
+    std::size_t lead, const char * p, const char * q, char raw, char next
+)
+{
+    if (lead == 0 && p == q)
+        return;
+
+    if (lead > 0 || is_blank(*p))
+    {
+        if (skip_blanks(p, q) == q && ignorable(raw, next))
+            return;
+
+        level & top { m_stack.back() };
+        if (top.space == -1)
+            top.space = -2;
+    }
+    m_text.append(lead, '\n');
+    m_text.append(p, q);
+}
+
+/**
+ *  Implements the heuristic of libxml2's areBlanks() for a chunk of blanks
+ *  in the current element.  Text already collected in m_text counts as a
+ *  text child, since libxml2 would have added it to the tree by now.
+ */
+
+bool
+XMLParser::ignorable (char raw, char next) const
+{
+    const level & top { m_stack.back() };
+    if (top.space == 1 || top.space == -2)
+        return false;
+
+    if (raw != '<' && raw != '\r')
+        return false;
+
+    if (top.node->children().empty() && m_text.empty())
+        return ! (raw == '<' && next == '/');
+
+    if (! m_text.empty() || top.last_is_text)
+        return false;
+
+    return ! top.first_is_text;
+}
+
+bool
+XMLParser::parse_comment (std::string & out)
+{
+    const char * start { m_cur + 4 };
+    const char * end { find_string(start, m_end, "-->") };
+    if (end == m_end)
+        return fail("unterminated comment");
+
+    if (find_string(start, end, "--") != end || (end > start && end[-1] == '-'))
+    {
+        m_cur = start;
+        return fail("'--' in comment");
+    }
+    if (! is_valid_text(start, end))
+        return fail("invalid character in comment");
+
+    out.clear();
+    append_normalized(out, start, end);
+    m_cur = end + 3;
+    return true;
+}
+
+bool
+XMLParser::parse_cdata (std::string & out)
+{
+    const char * start { m_cur + 9 };
+    const char * end { find_string(start, m_end, "]]>") };
+    if (end == m_end)
+        return fail("unterminated CDATA section");
+
+    if (! is_valid_text(start, end))
+        return fail("invalid character in CDATA section");
+
+    out.clear();
+    append_normalized(out, start, end);
+    m_cur = end + 3;
+    return true;
+}
+
+/**
+ *  Parses a processing instruction into its target and data; libxml2 drops
+ *  the blanks between them.
+ */
+
+bool
+XMLParser::parse_pi (std::string & target, std::string & data)
+{
+    const char * start { m_cur + 2 };
+    const char * end { find_string(start, m_end, "?>") };
+    if (end == m_end)
+        return fail("unterminated processing instruction");
+
+    const char * p { start };
+    while (p < end && ! is_blank(*p))
+        ++p;
+
+    if (! is_valid_name(start, p))
+        return fail("invalid processing instruction target");
+
+    bool reserved
+    {
+        p - start == 3 && (start[0] == 'x' || start[0] == 'X') &&
+        (start[1] == 'm' || start[1] == 'M') &&
+        (start[2] == 'l' || start[2] == 'L')
+    };
+    if (reserved)
+        return fail("reserved processing instruction target");
+
+    if (! is_valid_text(p, end))
+        return fail("invalid character in processing instruction");
+
+    target.assign(start, p);
+    data.clear();
+    append_normalized(data, skip_blanks(p, end), end);
+    m_cur = end + 2;
+    return true;
+}
+
+/**
+ *  Decodes a predefined entity or character reference, with m_cur at the
+ *  '&', and appends the result.
+ */
+
+bool
+XMLParser::parse_reference (std::string & out)
+{
+    const char * start { m_cur + 1 };
+    const char * limit { m_end - start > 12 ? start + 12 : m_end };
+    const char * semi
+    {
+        static_cast<const char *>
+        (
+            std::memchr(start, ';', std::size_t(limit - start))
+        )
+    };
+    if (is_nullptr(semi) || semi == start)
+        return fail("malformed reference");
+
+    std::size_t n { std::size_t(semi - start) };
+    if (*start == '#')
+    {
+        unsigned long cp { 0 };
+        const char * p { start + 1 };
+        int base { 10 };
+        if (p < semi && *p == 'x')
+        {
+            base = 16;
+            ++p;
+        }
+        if (p == semi)
+            return fail("malformed character reference");
+
+        for ( ; p < semi; ++p)
+        {
+            int d;
+            char c { *p };
+            if (c >= '0' && c <= '9')
+                d = c - '0';
+            else if (base == 16 && c >= 'a' && c <= 'f')
+                d = c - 'a' + 10;
+            else if (base == 16 && c >= 'A' && c <= 'F')
+                d = c - 'A' + 10;
+            else
+                return fail("malformed character reference");
+
+            cp = cp * unsigned(base) + unsigned(d);
+            if (cp > 0x10FFFF)
+                return fail("character reference out of range");
+        }
+
+        bool valid
+        {
+            cp == 0x9 || cp == 0xA || cp == 0xD ||
+            (cp >= 0x20 && cp <= 0xD7FF) ||
+            (cp >= 0xE000 && cp <= 0xFFFD) ||
+            (cp >= 0x10000 && cp <= 0x10FFFF)
+        };
+        if (! valid)
+            return fail("invalid character reference");
+
+        utf8::append(char32_t(cp), std::back_inserter(out));
+    }
+    else if (n == 2 && std::memcmp(start, "lt", 2) == 0)
+        out += '<';
+    else if (n == 2 && std::memcmp(start, "gt", 2) == 0)
+        out += '>';
+    else if (n == 3 && std::memcmp(start, "amp", 3) == 0)
+        out += '&';
+    else if (n == 4 && std::memcmp(start, "quot", 4) == 0)
+        out += '"';
+    else if (n == 4 && std::memcmp(start, "apos", 4) == 0)
+        out += '\'';
+    else
+        return fail("unsupported entity " + std::string(start, semi));
+
+    m_cur = semi + 1;
+    return true;
+}
+
+/**
+ *  Parses a quoted attribute value, with m_cur at the opening quote.  Per
+ *  the XML attribute-value normalization, literal tabs and line ends
+ *  become spaces, while those given as character references are kept.
+ */
+
+bool
+XMLParser::parse_attribute_value (std::string & out)
+{
+    if (m_cur == m_end || (*m_cur != '"' && *m_cur != '\''))
+        return fail("attribute value must be quoted");
+
+    char quote { *m_cur++ };
+    out.clear();
+    for (;;)
+    {
+        const char * p { scan_attribute(m_cur, m_end, quote) };
+        out.append(m_cur, p);
+        m_cur = p;
+        if (p == m_end)
+            return fail("unterminated attribute value");
+
+        char c { *p };
+        if (c == quote)
+        {
+            ++m_cur;
+            return true;
+        }
+        if (c == '&')
+        {
+            if (! parse_reference(out))
+                return false;
+        }
+        else if (c == '<')
+            return fail("'<' in attribute value");
+        else if (c == '\r')
+        {
+            out += ' ';
+            ++m_cur;
+            if (m_cur < m_end && *m_cur == '\n')
+                ++m_cur;
+        }
+        else if (c == '\n' || c == '\t')
+        {
+            out += ' ';
+            ++m_cur;
+        }
+        else
+            return fail("invalid character in attribute value");
+    }
+}
+
+/**
+ *  Adds m_text, if any, to the current element as a "text" node.
+ */
+
+void
+XMLParser::flush_text ()
+{
+    if (! m_text.empty())
+    {
+        XMLNode * node { new XMLNode("text") };
+        node->set_content(m_text);
+        add_node(node, true);
+    }
+}
+
+void
+XMLParser::add_node (XMLNode * node, bool is_text)
+{
+    level & top { m_stack.back() };
+    if (top.node->children().empty())
+        top.first_is_text = is_text;
+
+    top.last_is_text = is_text;
+    top.node->add_child_nocopy(*node);
+}
+
+}           // namespace xml66
+
+/*
+ * xml66parser.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
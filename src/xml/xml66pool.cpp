@@ -0,0 +1,126 @@
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66pool.cpp
+ *
+ *    Provides a pool of reusable libxml2 parser contexts.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ */
+
+#include "c_macros.h"                   /* lib66's is_nullptr() etc. macros */
+#include "xml/xml66pool.hpp"            /* xml66::XMLParserPool class       */
+
+namespace xml66
+{
+
+/**
+ * \param capacity
+ *      The most idle contexts kept.  Contexts released beyond that are
+ *      freed.
+ */
+
+XMLParserPool::XMLParserPool (std::size_t capacity) :
+    m_mutex     (),
+    m_capacity  (capacity)
+{
+    m_idle.reserve(capacity);
+}
+
+XMLParserPool::~XMLParserPool ()
+{
+    for (auto ctxt : m_idle)
+        xmlFreeParserCtxt(ctxt);
+}
+
+/**
+ *  Takes an idle context, or creates one if there is none.
+ *
+ * \return
+ *      Returns nullptr only if libxml2 cannot allocate a context.
+ */
+
+xmlParserCtxtPtr
+XMLParserPool::acquire ()
+{
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        if (! m_idle.empty())
+        {
+            xmlParserCtxtPtr ctxt { m_idle.back() };
+            m_idle.pop_back();
+            return ctxt;
+        }
+    }
+    return xmlNewParserCtxt();
+}
+
+/**
+ *  Resets a context and keeps it for the next acquire(), or frees it if
+ *  the pool is full.  A null context is ignored.
+ */
+
+void
+XMLParserPool::release (xmlParserCtxtPtr ctxt)
+{
+    if (is_nullptr(ctxt))
+        return;
+
+    xmlCtxtReset(ctxt);
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        if (m_idle.size() < m_capacity)
+        {
+            m_idle.push_back(ctxt);
+            return;
+        }
+    }
+    xmlFreeParserCtxt(ctxt);
+}
+
+std::size_t
+XMLParserPool::idle () const
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    return m_idle.size();
+}
+
+/**
+ *  The pool of the calling thread, used by every XMLTree that has not been
+ *  given a pool of its own.  Its contexts are freed when the thread ends.
+ */
+
+XMLParserPool &
+XMLParserPool::thread_pool ()
+{
+    static thread_local XMLParserPool s_pool;
+    return s_pool;
+}
+
+}           // namespace xml66
+
+/*
+ * xml66pool.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,173 @@
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66query.cpp
+ *
+ *    Provides compiled XPath queries and a cache of them.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ */
+
+#include "c_macros.h"                   /* lib66's is_nullptr() etc. macros */
+#include "xml/xml66query.hpp"           /* xml66::XMLQuery, XMLQueryCache   */
+#include "xml/xml66xx.hpp"              /* xml66::XMLException              */
+
+namespace xml66
+{
+
+/**
+ * Class: XMLQuery
+ */
+
+/**
+ *  Compiles the expression with libxml2 and, if it is in the supported
+ *  subset, with XMLXPath.
+ *
+ * \throw
+ *      Throws XMLException("Invalid XPath: ...") if libxml2 cannot compile
+ *      the expression, as XMLTree::find() always has.
+ */
+
+XMLQuery::XMLQuery (const std::string & xpath) :
+    m_text      (xpath),
+    m_native    (XMLXPath::compile(xpath)),
+    m_compiled  (xmlXPathCompile((const xmlChar *) xpath.c_str()))
+{
+    if (is_nullptr(m_compiled))
+        throw XMLException("Invalid XPath: " + xpath);
+}
+
+XMLQuery::~XMLQuery ()
+{
+    xmlXPathFreeCompExpr(m_compiled);
+}
+
+/**
+ * Class: XMLQueryCache
+ */
+
+/**
+ * \param capacity
+ *      The most queries kept.  Zero disables the cache, so that every
+ *      get() compiles the expression.
+ */
+
+XMLQueryCache::XMLQueryCache (std::size_t capacity) :
+    m_mutex     (),
+    m_capacity  (capacity)
+{
+    // No code
+}
+
+/**
+ *  Returns the compiled query for an expression, compiling and adding it
+ *  if it is not cached.  The compile is done without holding the lock; if
+ *  two threads compile the same new expression, the first one added wins.
+ *
+ * \throw
+ *      Throws XMLException if the expression is invalid.  Invalid
+ *      expressions are not cached.
+ */
+
+XMLQueryPtr
+XMLQueryCache::get (const std::string & xpath)
+{
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        auto it { m_index.find(xpath) };
+        if (it != m_index.end())
+        {
+            m_queries.splice(m_queries.begin(), m_queries, it->second);
+            return m_queries.front();
+        }
+    }
+
+    XMLQueryPtr result { std::make_shared<const XMLQuery>(xpath) };
+    std::lock_guard<std::mutex> lock { m_mutex };
+    if (m_capacity == 0)
+        return result;
+
+    auto it { m_index.find(xpath) };
+    if (it != m_index.end())
+    {
+        m_queries.splice(m_queries.begin(), m_queries, it->second);
+        return m_queries.front();
+    }
+    m_queries.push_front(result);
+    m_index.emplace(std::string_view(result->text()), m_queries.begin());
+    trim();
+    return result;
+}
+
+void
+XMLQueryCache::set_capacity (std::size_t capacity)
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    m_capacity = capacity;
+    trim();
+}
+
+std::size_t
+XMLQueryCache::capacity () const
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    return m_capacity;
+}
+
+std::size_t
+XMLQueryCache::size () const
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    return m_queries.size();
+}
+
+void
+XMLQueryCache::clear ()
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    m_index.clear();
+    m_queries.clear();
+}
+
+/**
+ *  Drops the least recently used queries beyond the capacity.  The caller
+ *  holds the lock.
+ */
+
+void
+XMLQueryCache::trim ()
+{
+    while (m_queries.size() > m_capacity)
+    {
+        (void) m_index.erase(std::string_view(m_queries.back()->text()));
+        m_queries.pop_back();
+    }
+}
+
+}           // namespace xml66
+
+/*
+ * xml66query.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,384 @@
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66stream.cpp
+ *
+ *    Provides XPath queries evaluated while a file is read.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ *
+ *  The reader's events are matched against the expression with an
+ *  XMLXPath::matcher.  Each open element has a frame holding the matcher
+ *  states for its children.  An element that cannot lead to a match is
+ *  not pushed, and its subtree is passed over with xmlTextReaderNext(); an
+ *  element that might is built only long enough to test its attributes.
+ *  A selected element becomes the capture, and everything under it is
+ *  built until its end tag, when it is made ready.
+ */
+
+#include "cpp_types.hpp"                /* lib66's CSTR() etc. macros       */
+#include "xml/xml66stream.hpp"          /* xml66::XMLStream class           */
+
+namespace xml66
+{
+
+namespace
+{
+
+/**
+ *  Compiles an expression that XMLStream can evaluate.
+ *
+ * \throw
+ *      Throws XMLException("XPath not supported for streaming: ...") if the
+ *      expression is not valid, or is not XMLXPath::streamable().
+ */
+
+std::unique_ptr<XMLXPath>
+compile_streamable (const std::string & xpath)
+{
+    std::unique_ptr<XMLXPath> result { XMLXPath::compile(xpath) };
+    if (! result || ! result->streamable())
+        throw XMLException("XPath not supported for streaming: " + xpath);
+
+    return result;
+}
+
+}           // namespace anonymous
+
+/**
+ * Class: XMLStream
+ */
+
+/**
+ *  Compiles the expression and opens the file.  Nothing is read until
+ *  next() is called.
+ *
+ * \param filename
+ *      The XML file to query.  If it cannot be opened, next() returns null
+ *      and good() is false.
+ *
+ * \param xpath
+ *      The expression, which must be XMLXPath::streamable().
+ *
+ * \throw
+ *      Throws XMLException if the expression cannot be evaluated while
+ *      streaming.
+ */
+
+XMLStream::XMLStream
+(
+    const std::string & filename, const std::string & xpath
+) :
+    m_filename  (filename),
+    m_xpath     (compile_streamable(xpath)),
+    m_matcher   (*m_xpath),
+    m_reader
+    (
+        xmlReaderForFile
+        (
+            CSTR(filename), NULL, XML_PARSE_NOBLANKS | XML_PARSE_HUGE
+        )
+    ),
+    m_frames    (),
+    m_capture   (nullptr),
+    m_nested    (),
+    m_ready     (),
+    m_skip      (false),
+    m_done      (is_nullptr(m_reader)),
+    m_good      (not_nullptr(m_reader))
+{
+    m_frames.push_back(frame { m_matcher.start(), nullptr });
+}
+
+XMLStream::~XMLStream ()
+{
+    release();
+}
+
+/**
+ *  Reads until the next selected node is complete.
+ *
+ * \return
+ *      Returns a copy of the node, as XMLTree::find() makes, or null at the
+ *      end of the file or at an error (see good()).
+ */
+
+XMLNodePtr
+XMLStream::next ()
+{
+    while (m_ready.empty() && ! m_done)
+        read();
+
+    if (m_ready.empty())
+        return XMLNodePtr();
+
+    XMLNodePtr result { std::move(m_ready.front()) };
+    m_ready.pop_front();
+    return result;
+}
+
+/**
+ *  Makes an XMLNode for the reader's current node.  The names and contents
+ *  match what XMLTree builds from the equivalent xmlDoc:  text nodes are
+ *  named "text", comments "comment", CDATA sections have an empty name,
+ *  and processing instructions are named for their target.
+ *
+ * \return
+ *      Returns an element with its attributes but no children, or a
+ *      content node, or null for other kinds of reader nodes.
+ */
+
+XMLNode *
+XMLStream::read_node (xmlTextReaderPtr reader)
+{
+    int type { xmlTextReaderNodeType(reader) };
+    if (type == XML_READER_TYPE_ELEMENT)
+    {
+        const xmlChar * name { xmlTextReaderConstLocalName(reader) };
+        XMLNode * tmp
+        {
+            new XMLNode(not_nullptr(name) ? (const char *) name : "")
+        };
+        bool check { false };               /* see add_property_nocheck()   */
+        while (xmlTextReaderMoveToNextAttribute(reader) == 1)
+        {
+            if (xmlTextReaderIsNamespaceDecl(reader) == 1)
+                continue;
+
+            if (not_nullptr(xmlTextReaderConstPrefix(reader)))
+                check = true;
+
+            const xmlChar * v { xmlTextReaderConstValue(reader) };
+            const char * aname
+            {
+                (const char *) xmlTextReaderConstLocalName(reader)
+            };
+            std::string value { not_nullptr(v) ? (const char *) v : "" };
+            if (check)
+                tmp->set_property(aname, value);
+            else
+                tmp->add_property_nocheck(aname, value);
+        }
+        xmlTextReaderMoveToElement(reader);
+        return tmp;
+    }
+
+    const char * name { nullptr };
+    switch (type)
+    {
+    case XML_READER_TYPE_TEXT:
+    case XML_READER_TYPE_WHITESPACE:
+    case XML_READER_TYPE_SIGNIFICANT_WHITESPACE:
+
+        name = "text";
+        break;
+
+    case XML_READER_TYPE_CDATA:
+
+        name = "";
+        break;
+
+    case XML_READER_TYPE_COMMENT:
+
+        name = "comment";
+        break;
+
+    case XML_READER_TYPE_PROCESSING_INSTRUCTION:
+    case XML_READER_TYPE_ENTITY_REFERENCE:
+
+        name = (const char *) xmlTextReaderConstLocalName(reader);
+        break;
+
+    default:
+
+        break;
+    }
+    if (is_nullptr(name))
+        return nullptr;
+
+    const xmlChar * v { xmlTextReaderConstValue(reader) };
+    XMLNode * tmp { new XMLNode(name) };
+    tmp->set_content(not_nullptr(v) ? (const char *) v : "");
+    return tmp;
+}
+
+/**
+ *  Handles one reader event.  At the end of the file, or at an error, the
+ *  reader and any unfinished capture are released.
+ */
+
+void
+XMLStream::read ()
+{
+    XMLEdits::quiet reading;            /* new nodes, not edits of a tree   */
+    int rc
+    {
+        m_skip ? xmlTextReaderNext(m_reader) : xmlTextReaderRead(m_reader)
+    };
+    m_skip = false;
+    if (rc != 1)
+    {
+        m_good = rc == 0;
+        release();
+        return;
+    }
+
+    int type { xmlTextReaderNodeType(m_reader) };
+    if (type == XML_READER_TYPE_END_ELEMENT)
+        end_element();
+    else if (type == XML_READER_TYPE_ELEMENT)
+        element();
+    else
+        content();
+}
+
+/**
+ *  Tests an element when its start tag is read.  Outside a capture, an
+ *  element that completes the path starts one; one whose attributes are
+ *  selected has them made ready; one that leaves no states for its
+ *  children has its subtree skipped.  Inside a capture, every element is
+ *  added to it, and those selected are noted to be copied after it.
+ */
+
+void
+XMLStream::element ()
+{
+    bool empty { xmlTextReaderIsEmptyElement(m_reader) == 1 };
+    XMLNode * node { read_node(m_reader) };
+    XMLXPath::matcher::states states;
+    XMLXPath::hit_list hits
+    {
+        m_matcher.step(*node, m_frames.back().states, states)
+    };
+    if (not_nullptr(m_capture))
+    {
+        m_frames.back().node->add_child_nocopy(*node);
+        if (! hits.empty())
+            m_nested.push_back(node);
+    }
+    else if (! hits.empty() && is_nullptr(hits.front().property))
+    {
+        m_capture = node;
+    }
+    else
+    {
+        for (const auto & h : hits)
+        {
+            XMLNode * copy { new XMLNode(h.property->atom()) };
+            XMLNode * text { copy->emplace_child(std::string("text")) };
+            (void) text->set_content(h.property->value());
+            m_ready.push_back(XMLNodePtr(copy));
+        }
+        delete node;
+        node = nullptr;
+        if (states.empty())
+        {
+            m_skip = ! empty;
+            return;
+        }
+    }
+    if (empty)
+        finish(node);
+    else
+        m_frames.push_back(frame { std::move(states), node });
+}
+
+/**
+ *  Tests a content node.  Outside a capture, it is kept only if it is
+ *  selected.
+ */
+
+void
+XMLStream::content ()
+{
+    if (m_frames.size() == 1)
+        return;                         /* ignore prolog, epilog nodes      */
+
+    XMLNode * node { read_node(m_reader) };
+    if (is_nullptr(node))
+        return;
+
+    frame & parent { m_frames.back() };
+    XMLXPath::matcher::states states;
+    XMLXPath::hit_list hits { m_matcher.step(*node, parent.states, states) };
+    if (not_nullptr(parent.node))
+    {
+        parent.node->add_child_nocopy(*node);
+        if (! hits.empty())
+            m_nested.push_back(node);
+    }
+    else if (hits.empty())
+        delete node;
+    else
+        m_ready.push_back(XMLNodePtr(node));
+}
+
+void
+XMLStream::end_element ()
+{
+    XMLNode * node { m_frames.back().node };
+    m_frames.pop_back();
+    finish(node);
+}
+
+/**
+ *  If the element is the capture, makes it ready, followed by copies of
+ *  the selected nodes inside it, in document order.
+ */
+
+void
+XMLStream::finish (XMLNode * node)
+{
+    if (is_nullptr(node) || node != m_capture)
+        return;
+
+    m_ready.push_back(XMLNodePtr(m_capture));
+    m_capture = nullptr;
+    for (auto n : m_nested)
+        m_ready.push_back(XMLNodePtr(new XMLNode(*n)));
+
+    m_nested.clear();
+}
+
+void
+XMLStream::release ()
+{
+    m_done = true;
+    if (not_nullptr(m_reader))
+    {
+        xmlFreeTextReader(m_reader);
+        m_reader = nullptr;
+    }
+    delete m_capture;
+    m_capture = nullptr;
+    m_nested.clear();
+    m_frames.clear();
+}
+
+}           // namespace xml66
+
+/*
+ * xml66stream.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,2920 @@
+/*
+ *  This file is part of xml66.
+ *
+ *  xml66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xml66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xml66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          xml66xpath.cpp
+ *
+ *    Provides XPath evaluation directly on an XMLNode tree.
+ *
+ * \library       xml66 library
+ * \author        Chris Ahlstrom
+ * \date          2026-10-16
+ * \updates       2026-10-16
+ * \version       $Revision$
+ *
+ *  The expression is parsed by recursive descent into a tree of expression
+ *  nodes, following the XPath 1.0 grammar.  A '//' followed by a child
+ *  step without positional predicates is folded into one descendant step,
+ *  so "//Patch[@Name]" is a single walk of the tree.
+ *
+ *  A child or descendant step whose first predicate compares an attribute
+ *  with a string, such as "Source[@id='1234']", is answered from an
+ *  XMLIndex of that element and attribute, if the caller passes one.
+ *
+ *  compile() also plans simple paths (see XMLXPath::path), which select()
+ *  walks directly instead of evaluating.
+ *
+ *  select_many() runs several forward paths as one automaton.  Its states
+ *  are (path, step) pairs.  Each node gets the states of its parent that
+ *  it may match; a match advances the state to the next step for the
+ *  node's children, and a descendant step also stays active for them.
+ *  One depth-first pass then answers all of the paths, in document order.
+ *  XMLXPath::matcher runs the same automaton for one path, a node at a
+ *  time, as XMLStream reads a document.
+ *
+ *  Node-sets are kept in document order without duplicates.  Steps from a
+ *  single context node along a forward axis produce that order directly;
+ *  otherwise the step's result is sorted, using an index of document
+ *  positions (and parents, for the reverse axes) built on first use.
+ */
+
+#include <algorithm>                    /* std::sort(), std::unique()       */
+#include <cfloat>                       /* DBL_DIG                          */
+#include <climits>                      /* INT_MIN, INT_MAX                 */
+#include <cmath>                        /* std::floor(), std::isnan(), etc. */
+#include <cstdio>                       /* std::snprintf()                  */
+#include <limits>                       /* std::numeric_limits<>            */
+#include <unordered_map>                /* std::unordered_map<>             */
+#include <unordered_set>                /* std::unordered_set<>             */
+#include <utility>                      /* std::pair<>, std::move()         */
+
+#include "xml/xml66xpath.hpp"           /* xml66::XMLXPath class            */
+#include "xml/xml66xx.hpp"              /* xml66::XMLNode, XMLException     */
+
+namespace xml66
+{
+
+namespace
+{
+
+using hit = XMLXPath::hit;
+using hit_list = XMLXPath::hit_list;
+
+/**
+ *  Thrown by the parser for an expression outside the supported subset,
+ *  or not valid at all, and caught by XMLXPath::compile().
+ */
+
+struct unsupported { };
+
+enum class axis
+{
+    child,
+    descendant,
+    descendant_or_self,
+    self,
+    parent,
+    ancestor,
+    ancestor_or_self,
+    following_sibling,
+    preceding_sibling,
+    attribute
+};
+
+enum class node_test
+{
+    name,                               /* an element or attribute name     */
+    any,                                /* '*'                              */
+    text,                               /* text()                           */
+    node                                /* node()                           */
+};
+
+enum class op
+{
+    or_op, and_op, eq, ne, lt, le, gt, ge,
+    add, sub, mul, div, mod, negate, union_op,
+    literal, number, function, path
+};
+
+enum class function
+{
+    last, position, count, name, local_name, string, concat,
+    starts_with, contains, substring_before, substring_after, substring,
+    string_length, normalize_space, translate, not_fn, true_fn, false_fn,
+    boolean, number, sum, floor, ceiling, round
+};
+
+struct function_info
+{
+    const char * name;
+    function fn;
+    int min_args;
+    int max_args;                       /* -1 for any number                */
+};
+
+const function_info s_functions [] =
+{
+    { "last",               function::last,             0, 0  },
+    { "position",           function::position,         0, 0  },
+    { "count",              function::count,            1, 1  },
+    { "name",               function::name,             0, 1  },
+    { "local-name",         function::local_name,       0, 1  },
+    { "string",             function::string,           0, 1  },
+    { "concat",             function::concat,           2, -1 },
+    { "starts-with",        function::starts_with,      2, 2  },
+    { "contains",           function::contains,         2, 2  },
+    { "substring-before",   function::substring_before, 2, 2  },
+    { "substring-after",    function::substring_after,  2, 2  },
+    { "substring",          function::substring,        2, 3  },
+    { "string-length",      function::string_length,    0, 1  },
+    { "normalize-space",    function::normalize_space,  0, 1  },
+    { "translate",          function::translate,        3, 3  },
+    { "not",                function::not_fn,           1, 1  },
+    { "true",               function::true_fn,          0, 0  },
+    { "false",              function::false_fn,         0, 0  },
+    { "boolean",            function::boolean,          1, 1  },
+    { "number",             function::number,           0, 1  },
+    { "sum",                function::sum,              1, 1  },
+    { "floor",              function::floor,            1, 1  },
+    { "ceiling",            function::ceiling,          1, 1  },
+    { "round",              function::round,            1, 1  }
+};
+
+}           // namespace anonymous
+
+/**
+ *  One step of a location path.
+ */
+
+struct xpath_step
+{
+    axis a { axis::child };
+    node_test test { node_test::node };
+    XMLName name { };
+    std::vector<std::unique_ptr<XMLXPath::expression>> predicates { };
+    bool positional { false };          /* a predicate may use positions    */
+};
+
+/**
+ *  A node of the parsed expression.  Operators keep their operands, and
+ *  functions their arguments, in args.
+ */
+
+struct XMLXPath::expression
+{
+    op kind { op::literal };
+    std::vector<std::unique_ptr<expression>> args { };
+    std::string literal { };
+    double number { 0.0 };
+    function fn { function::last };
+    bool absolute { false };
+    std::vector<xpath_step> steps { };
+};
+
+namespace
+{
+
+using expression = XMLXPath::expression;
+using expression_ptr = std::unique_ptr<expression>;
+
+/**
+ *  Tests for a step that an XMLIndex can answer:  a child or descendant
+ *  step with a name test, whose first predicate is "@attribute='value'"
+ *  (or "'value'=@attribute").
+ *
+ * \param [out] attribute
+ *      Set to the name of the attribute compared.
+ *
+ * \param [out] value
+ *      Set to point to the string it is compared with.
+ */
+
+bool
+equality_step
+(
+    const xpath_step & s, XMLName & attribute, const std::string * & value
+)
+{
+    bool shape
+    {
+        (s.a == axis::child || s.a == axis::descendant) &&
+        s.test == node_test::name && ! s.predicates.empty() &&
+        s.predicates.front()->kind == op::eq
+    };
+    if (! shape)
+        return false;
+
+    const expression & p { *s.predicates.front() };
+    for (int i = 0; i < 2; ++i)
+    {
+        const expression & lhs { *p.args[i] };
+        const expression & rhs { *p.args[1 - i] };
+        bool match
+        {
+            lhs.kind == op::path && ! lhs.absolute &&
+            lhs.steps.size() == 1 &&
+            lhs.steps.front().a == axis::attribute &&
+            lhs.steps.front().test == node_test::name &&
+            lhs.steps.front().predicates.empty() &&
+            rhs.kind == op::literal
+        };
+        if (match)
+        {
+            attribute = lhs.steps.front().name;
+            value = &rhs.literal;
+            return true;
+        }
+    }
+    return false;
+}
+
+const XMLIndex *
+find_index
+(
+    const XMLIndexList * indexes, XMLName element, XMLName attribute
+)
+{
+    if (not_nullptr(indexes))
+    {
+        for (const auto & x : *indexes)
+        {
+            if (x->element() == element && x->attribute() == attribute)
+                return x.get();
+        }
+    }
+    return nullptr;
+}
+
+/**
+ *  Converts an absolute location path of child steps with name tests, each
+ *  with at most one predicate of the form equality_step() accepts, into a
+ *  simple path.
+ *
+ * \return
+ *      Returns false, leaving steps empty, for any other expression.
+ */
+
+bool
+simple_path (const expression & e, XMLXPath::path & steps)
+{
+    if (e.kind != op::path || ! e.absolute || e.steps.empty())
+        return false;
+
+    for (const auto & s : e.steps)
+    {
+        XMLXPath::path_step ps { s.name, XMLName(), std::string() };
+        if (s.a != axis::child || s.test != node_test::name)
+        {
+            steps.clear();
+            return false;
+        }
+        if (! s.predicates.empty())
+        {
+            const std::string * value { nullptr };
+            bool one
+            {
+                s.predicates.size() == 1 &&
+                equality_step(s, ps.attribute, value)
+            };
+            if (! one)
+            {
+                steps.clear();
+                return false;
+            }
+            ps.value = *value;
+        }
+        steps.push_back(std::move(ps));
+    }
+    return true;
+}
+
+/**
+ *  True if select_many() can evaluate the expression:  an absolute path of
+ *  child and descendant steps, without positional predicates, and
+ *  optionally ending with an attribute step without predicates.
+ */
+
+bool
+forward_path (const expression & e)
+{
+    if (e.kind != op::path || ! e.absolute || e.steps.empty())
+        return false;
+
+    for (std::size_t i = 0; i < e.steps.size(); ++i)
+    {
+        const xpath_step & s { e.steps[i] };
+        bool ok
+        {
+            s.a == axis::child || s.a == axis::descendant ||
+            (
+                s.a == axis::attribute && i > 0 &&
+                i + 1 == e.steps.size() && s.predicates.empty()
+            )
+        };
+        if (! ok || s.positional)
+            return false;
+    }
+    return true;
+}
+
+/**
+ *  True if a predicate looks only at the attributes of the context node,
+ *  so that it can be tested when the start tag is read:  its paths are
+ *  single attribute steps, and it does not take the string value of the
+ *  context node.
+ */
+
+bool
+attribute_only (const expression & e)
+{
+    if (e.kind == op::path)
+    {
+        return ! e.absolute && e.steps.size() == 1 &&
+            e.steps.front().a == axis::attribute &&
+            e.steps.front().predicates.empty();
+    }
+    if (e.kind == op::function && e.args.empty())
+    {
+        switch (e.fn)
+        {
+        case function::string:
+        case function::string_length:
+        case function::normalize_space:
+        case function::number:
+
+            return false;
+
+        default:
+
+            break;
+        }
+    }
+    for (const auto & a : e.args)
+    {
+        if (! attribute_only(*a))
+            return false;
+    }
+    return true;
+}
+
+/**
+ *  True if XMLStream can evaluate the expression:  a forward path whose
+ *  predicates use only attributes.
+ */
+
+bool
+stream_path (const expression & e)
+{
+    if (! forward_path(e))
+        return false;
+
+    for (const auto & s : e.steps)
+    {
+        for (const auto & p : s.predicates)
+        {
+            if (! attribute_only(*p))
+                return false;
+        }
+    }
+    return true;
+}
+
+/**
+ *  True if the element has the attribute with the value.
+ */
+
+bool
+has_value (const XMLNode & node, XMLName attribute, const std::string & value)
+{
+    for (auto prop : node.properties())
+    {
+        if (prop->atom() == attribute)
+            return prop->value() == value;
+    }
+    return false;
+}
+
+/**
+ *  True if any step of the expression, or of its predicates, can be
+ *  answered by one of the indexes.
+ */
+
+bool
+uses_index (const expression & e, const XMLIndexList & indexes)
+{
+    for (const auto & s : e.steps)
+    {
+        XMLName attribute;
+        const std::string * value { nullptr };
+        if (equality_step(s, attribute, value))
+        {
+            if (not_nullptr(find_index(&indexes, s.name, attribute)))
+                return true;
+        }
+        for (const auto & p : s.predicates)
+        {
+            if (uses_index(*p, indexes))
+                return true;
+        }
+    }
+    for (const auto & a : e.args)
+    {
+        if (uses_index(*a, indexes))
+            return true;
+    }
+    return false;
+}
+
+/*
+ * ------------------------------------------------------------------------
+ *  Lexer
+ * ------------------------------------------------------------------------
+ */
+
+enum class token_kind
+{
+    end, slash, dslash, lbracket, rbracket, lparen, rparen, at, comma,
+    pipe, dot, ddot, dcolon, star, eq, ne, lt, le, gt, ge, plus, minus,
+    literal, number, name, op_and, op_or, op_div, op_mod, op_mul
+};
+
+struct token
+{
+    token_kind kind { token_kind::end };
+    std::string text { };
+    double number { 0.0 };
+};
+
+inline bool
+is_space (char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline bool
+is_digit (char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool
+is_name_start (char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+        (static_cast<unsigned char>(c) & 0x80) != 0;
+}
+
+inline bool
+is_name_char (char c)
+{
+    return is_name_start(c) || is_digit(c) || c == '-' || c == '.';
+}
+
+/**
+ *  Reads the digits, fraction, and exponent of a number at s[i] the way
+ *  libxml2's xmlXPathCompNumber() and xmlXPathStringEvalNumber() do, so
+ *  that both engines get the same double:  the integer part is summed
+ *  digit by digit, at most 20 digits of the fraction (after its leading
+ *  zeros) are divided by a power of ten, and an exponent is applied with
+ *  std::pow().  The steps are kept separate, as in libxml2, so that the
+ *  rounding is the same.
+ *
+ * \param s
+ *      The text.
+ *
+ * \param i
+ *      The position of the number, updated to the position after it.
+ *
+ * \param result
+ *      Set to the value read.
+ *
+ * \return
+ *      Returns false if there is a point with no digits on either side.
+ */
+
+bool
+scan_number (const std::string & s, std::size_t & i, double & result)
+{
+    const std::size_t n { s.size() };
+    double value { 0.0 };
+    bool digits { false };
+    while (i < n && is_digit(s[i]))
+    {
+        value = value * 10;
+        value = value + double(s[i++] - '0');
+        digits = true;
+    }
+    if (i < n && s[i] == '.')
+    {
+        ++i;
+        if (! digits && (i == n || ! is_digit(s[i])))
+            return false;
+
+        int frac { 0 };
+        double fraction { 0.0 };
+        while (i < n && s[i] == '0')
+        {
+            ++frac;
+            ++i;
+        }
+
+        int limit { frac + 20 };
+        while (i < n && is_digit(s[i]) && frac < limit)
+        {
+            fraction = fraction * 10;
+            fraction = fraction + double(s[i++] - '0');
+            ++frac;
+        }
+        fraction /= std::pow(10.0, frac);
+        value = value + fraction;
+        while (i < n && is_digit(s[i]))
+            ++i;
+    }
+    if (i < n && (s[i] == 'e' || s[i] == 'E'))
+    {
+        bool negative { false };
+        if (++i < n && s[i] == '-')
+        {
+            negative = true;
+            ++i;
+        }
+        else if (i < n && s[i] == '+')
+            ++i;
+
+        int exponent { 0 };
+        while (i < n && is_digit(s[i]))
+        {
+            if (exponent < 1000000)
+                exponent = exponent * 10 + (s[i] - '0');
+
+            ++i;
+        }
+        value *= std::pow(10.0, double(negative ? -exponent : exponent));
+    }
+    result = value;
+    return true;
+}
+
+/**
+ *  Splits the expression into tokens.  Following the XPath rules, a '*'
+ *  or a name is an operator when it follows a token that can end an
+ *  operand.
+ */
+
+std::vector<token>
+tokenize (const std::string & text)
+{
+    std::vector<token> result;
+    std::size_t i { 0 };
+    const std::size_t n { text.size() };
+    auto operand_ended = [&result] () -> bool
+    {
+        if (result.empty())
+            return false;
+
+        switch (result.back().kind)
+        {
+        case token_kind::at:        case token_kind::dcolon:
+        case token_kind::lparen:    case token_kind::lbracket:
+        case token_kind::comma:     case token_kind::op_and:
+        case token_kind::op_or:     case token_kind::op_div:
+        case token_kind::op_mod:    case token_kind::op_mul:
+        case token_kind::slash:     case token_kind::dslash:
+        case token_kind::pipe:      case token_kind::plus:
+        case token_kind::minus:     case token_kind::eq:
+        case token_kind::ne:        case token_kind::lt:
+        case token_kind::le:        case token_kind::gt:
+        case token_kind::ge:
+
+            return false;
+
+        default:
+
+            return true;
+        }
+    };
+    while (i < n)
+    {
+        char c { text[i] };
+        if (is_space(c))
+        {
+            ++i;
+            continue;
+        }
+
+        token t;
+        char next { i + 1 < n ? text[i + 1] : '\0' };
+        if (c == '/')
+        {
+            t.kind = next == '/' ? token_kind::dslash : token_kind::slash;
+            i += next == '/' ? 2 : 1;
+        }
+        else if (c == '[') { t.kind = token_kind::lbracket; ++i; }
+        else if (c == ']') { t.kind = token_kind::rbracket; ++i; }
+        else if (c == '(') { t.kind = token_kind::lparen; ++i; }
+        else if (c == ')') { t.kind = token_kind::rparen; ++i; }
+        else if (c == '@') { t.kind = token_kind::at; ++i; }
+        else if (c == ',') { t.kind = token_kind::comma; ++i; }
+        else if (c == '|') { t.kind = token_kind::pipe; ++i; }
+        else if (c == '+') { t.kind = token_kind::plus; ++i; }
+        else if (c == '-') { t.kind = token_kind::minus; ++i; }
+        else if (c == '=') { t.kind = token_kind::eq; ++i; }
+        else if (c == '!')
+        {
+            if (next != '=')
+                throw unsupported();
+
+            t.kind = token_kind::ne;
+            i += 2;
+        }
+        else if (c == '<' || c == '>')
+        {
+            bool equal { next == '=' };
+            if (c == '<')
+                t.kind = equal ? token_kind::le : token_kind::lt;
+            else
+                t.kind = equal ? token_kind::ge : token_kind::gt;
+
+            i += equal ? 2 : 1;
+        }
+        else if (c == ':')
+        {
+            if (next != ':')
+                throw unsupported();
+
+            t.kind = token_kind::dcolon;
+            i += 2;
+        }
+        else if (c == '*')
+        {
+            t.kind = operand_ended() ? token_kind::op_mul : token_kind::star;
+            ++i;
+        }
+        else if (c == '"' || c == '\'')
+        {
+            std::size_t close { text.find(c, i + 1) };
+            if (close == std::string::npos)
+                throw unsupported();
+
+            t.kind = token_kind::literal;
+            t.text = text.substr(i + 1, close - i - 1);
+            i = close + 1;
+        }
+        else if (is_digit(c) || (c == '.' && is_digit(next)))
+        {
+            t.kind = token_kind::number;
+            (void) scan_number(text, i, t.number);
+        }
+        else if (c == '.')
+        {
+            t.kind = next == '.' ? token_kind::ddot : token_kind::dot;
+            i += next == '.' ? 2 : 1;
+        }
+        else if (is_name_start(c))
+        {
+            std::size_t start { i };
+            while (i < n && is_name_char(text[i]))
+                ++i;
+
+            t.text = text.substr(start, i - start);
+            if (i + 1 < n && text[i] == ':' && text[i + 1] != ':')
+                throw unsupported();    /* a namespace prefix           */
+
+            t.kind = token_kind::name;
+            if (operand_ended())
+            {
+                if (t.text == "and")
+                    t.kind = token_kind::op_and;
+                else if (t.text == "or")
+                    t.kind = token_kind::op_or;
+                else if (t.text == "div")
+                    t.kind = token_kind::op_div;
+                else if (t.text == "mod")
+                    t.kind = token_kind::op_mod;
+                else
+                    throw unsupported();
+            }
+        }
+        else
+            throw unsupported();        /* '$' variables, etc.          */
+
+        result.push_back(std::move(t));
+    }
+    result.push_back(token());
+    return result;
+}
+
+/*
+ * ------------------------------------------------------------------------
+ *  Parser
+ * ------------------------------------------------------------------------
+ */
+
+class parser
+{
+
+private:
+
+    const std::vector<token> & m_tokens;
+    std::size_t m_pos;
+
+public:
+
+    explicit parser (const std::vector<token> & tokens) :
+        m_tokens    (tokens),
+        m_pos       (0)
+    {
+        // No code
+    }
+
+    expression_ptr parse ()
+    {
+        expression_ptr result { parse_or() };
+        if (peek() != token_kind::end)
+            throw unsupported();
+
+        return result;
+    }
+
+private:
+
+    token_kind peek (std::size_t ahead = 0) const
+    {
+        std::size_t p { m_pos + ahead };
+        return p < m_tokens.size() ? m_tokens[p].kind : token_kind::end;
+    }
+
+    const token & current () const
+    {
+        return m_tokens[m_pos];
+    }
+
+    bool accept (token_kind k)
+    {
+        if (peek() != k)
+            return false;
+
+        ++m_pos;
+        return true;
+    }
+
+    void expect (token_kind k)
+    {
+        if (! accept(k))
+            throw unsupported();
+    }
+
+    static expression_ptr binary (op kind, expression_ptr a, expression_ptr b)
+    {
+        expression_ptr result { std::make_unique<expression>() };
+        result->kind = kind;
+        result->args.push_back(std::move(a));
+        result->args.push_back(std::move(b));
+        return result;
+    }
+
+    expression_ptr parse_or ()
+    {
+        expression_ptr result { parse_and() };
+        while (accept(token_kind::op_or))
+            result = binary(op::or_op, std::move(result), parse_and());
+
+        return result;
+    }
+
+    expression_ptr parse_and ()
+    {
+        expression_ptr result { parse_equality() };
+        while (accept(token_kind::op_and))
+            result = binary(op::and_op, std::move(result), parse_equality());
+
+        return result;
+    }
+
+    expression_ptr parse_equality ()
+    {
+        expression_ptr result { parse_relational() };
+        for (;;)
+        {
+            if (accept(token_kind::eq))
+                result = binary(op::eq, std::move(result), parse_relational());
+            else if (accept(token_kind::ne))
+                result = binary(op::ne, std::move(result), parse_relational());
+            else
+                return result;
+        }
+    }
+
+    expression_ptr parse_relational ()
+    {
+        expression_ptr result { parse_additive() };
+        for (;;)
+        {
+            op kind;
+            if (accept(token_kind::lt))
+                kind = op::lt;
+            else if (accept(token_kind::le))
+                kind = op::le;
+            else if (accept(token_kind::gt))
+                kind = op::gt;
+            else if (accept(token_kind::ge))
+                kind = op::ge;
+            else
+                return result;
+
+            result = binary(kind, std::move(result), parse_additive());
+        }
+    }
+
+    expression_ptr parse_additive ()
+    {
+        expression_ptr result { parse_multiplicative() };
+        for (;;)
+        {
+            op kind;
+            if (accept(token_kind::plus))
+                kind = op::add;
+            else if (accept(token_kind::minus))
+                kind = op::sub;
+            else
+                return result;
+
+            result = binary(kind, std::move(result), parse_multiplicative());
+        }
+    }
+
+    expression_ptr parse_multiplicative ()
+    {
+        expression_ptr result { parse_unary() };
+        for (;;)
+        {
+            op kind;
+            if (accept(token_kind::op_mul))
+                kind = op::mul;
+            else if (accept(token_kind::op_div))
+                kind = op::div;
+            else if (accept(token_kind::op_mod))
+                kind = op::mod;
+            else
+                return result;
+
+            result = binary(kind, std::move(result), parse_unary());
+        }
+    }
+
+    expression_ptr parse_unary ()
+    {
+        if (accept(token_kind::minus))
+        {
+            expression_ptr result { std::make_unique<expression>() };
+            result->kind = op::negate;
+            result->args.push_back(parse_unary());
+            return result;
+        }
+        return parse_union();
+    }
+
+    expression_ptr parse_union ()
+    {
+        expression_ptr result { parse_path_expr() };
+        while (accept(token_kind::pipe))
+            result = binary(op::union_op, std::move(result), parse_path_expr());
+
+        return result;
+    }
+
+    /**
+     *  A path, or a primary expression.  Primary expressions followed by a
+     *  predicate or a path (filter expressions) are not supported.
+     */
+
+    expression_ptr parse_path_expr ()
+    {
+        token_kind k { peek() };
+        bool primary
+        {
+            k == token_kind::literal || k == token_kind::number ||
+            k == token_kind::lparen ||
+            (
+                k == token_kind::name && peek(1) == token_kind::lparen &&
+                current().text != "text" && current().text != "node"
+            )
+        };
+        if (! primary)
+            return parse_location_path();
+
+        expression_ptr result { parse_primary() };
+        token_kind after { peek() };
+        if
+        (
+            after == token_kind::lbracket || after == token_kind::slash ||
+            after == token_kind::dslash
+        )
+        {
+            throw unsupported();
+        }
+        return result;
+    }
+
+    expression_ptr parse_primary ()
+    {
+        expression_ptr result { std::make_unique<expression>() };
+        if (peek() == token_kind::literal)
+        {
+            result->kind = op::literal;
+            result->literal = current().text;
+            ++m_pos;
+        }
+        else if (peek() == token_kind::number)
+        {
+            result->kind = op::number;
+            result->number = current().number;
+            ++m_pos;
+        }
+        else if (accept(token_kind::lparen))
+        {
+            result = parse_or();
+            expect(token_kind::rparen);
+        }
+        else
+        {
+            const std::string & name { current().text };
+            const function_info * info { nullptr };
+            for (const auto & f : s_functions)
+            {
+                if (name == f.name)
+                {
+                    info = &f;
+                    break;
+                }
+            }
+            if (is_nullptr(info))
+                throw unsupported();
+
+            ++m_pos;
+            expect(token_kind::lparen);
+            result->kind = op::function;
+            result->fn = info->fn;
+            if (! accept(token_kind::rparen))
+            {
+                do
+                {
+                    result->args.push_back(parse_or());
+                } while (accept(token_kind::comma));
+
+                expect(token_kind::rparen);
+            }
+            int count { int(result->args.size()) };
+            if
+            (
+                count < info->min_args ||
+                (info->max_args >= 0 && count > info->max_args)
+            )
+            {
+                throw unsupported();
+            }
+        }
+        return result;
+    }
+
+    expression_ptr parse_location_path ()
+    {
+        expression_ptr result { std::make_unique<expression>() };
+        result->kind = op::path;
+        if (accept(token_kind::slash))
+        {
+            result->absolute = true;
+            if (! starts_step())
+                return result;          /* "/" alone is the document    */
+        }
+        else if (accept(token_kind::dslash))
+        {
+            result->absolute = true;
+            result->steps.push_back(descendant_or_self());
+        }
+        for (;;)
+        {
+            result->steps.push_back(parse_step());
+            if (accept(token_kind::dslash))
+                result->steps.push_back(descendant_or_self());
+            else if (! accept(token_kind::slash))
+                break;
+        }
+        fold_descendants(result->steps);
+        return result;
+    }
+
+    bool starts_step () const
+    {
+        token_kind k { peek() };
+        return k == token_kind::name || k == token_kind::star ||
+            k == token_kind::at || k == token_kind::dot ||
+            k == token_kind::ddot;
+    }
+
+    static xpath_step descendant_or_self ()
+    {
+        xpath_step result;
+        result.a = axis::descendant_or_self;
+        result.test = node_test::node;
+        return result;
+    }
+
+    xpath_step parse_step ()
+    {
+        xpath_step result;
+        if (accept(token_kind::dot))
+        {
+            result.a = axis::self;
+            return result;
+        }
+        if (accept(token_kind::ddot))
+        {
+            result.a = axis::parent;
+            return result;
+        }
+        if (accept(token_kind::at))
+        {
+            result.a = axis::attribute;
+        }
+        else if (peek() == token_kind::name && peek(1) == token_kind::dcolon)
+        {
+            result.a = axis_named(current().text);
+            m_pos += 2;
+        }
+        if (accept(token_kind::star))
+        {
+            result.test = node_test::any;
+        }
+        else if (peek() == token_kind::name)
+        {
+            std::string name { current().text };
+            ++m_pos;
+            if (accept(token_kind::lparen))
+            {
+                expect(token_kind::rparen);
+                if (name == "text")
+                    result.test = node_test::text;
+                else if (name == "node")
+                    result.test = node_test::node;
+                else
+                    throw unsupported();    /* comment(), etc.          */
+            }
+            else
+            {
+                result.test = node_test::name;
+                result.name = XMLName(name);
+            }
+        }
+        else
+            throw unsupported();
+
+        while (accept(token_kind::lbracket))
+        {
+            expression_ptr predicate { parse_or() };
+            expect(token_kind::rbracket);
+            if (positional(*predicate))
+                result.positional = true;
+
+            result.predicates.push_back(std::move(predicate));
+        }
+        return result;
+    }
+
+    static axis axis_named (const std::string & name)
+    {
+        static const std::pair<const char *, axis> s_axes [] =
+        {
+            { "child",              axis::child                 },
+            { "descendant",         axis::descendant            },
+            { "descendant-or-self", axis::descendant_or_self    },
+            { "self",               axis::self                  },
+            { "parent",             axis::parent                },
+            { "ancestor",           axis::ancestor              },
+            { "ancestor-or-self",   axis::ancestor_or_self      },
+            { "following-sibling",  axis::following_sibling     },
+            { "preceding-sibling",  axis::preceding_sibling     },
+            { "attribute",          axis::attribute             }
+        };
+        for (const auto & a : s_axes)
+        {
+            if (name == a.first)
+                return a.second;
+        }
+        throw unsupported();            /* following, preceding, etc.   */
+    }
+
+    /**
+     *  True if a predicate might depend on the position of the node, either
+     *  because it is a number or because it calls position() or last().
+     */
+
+    static bool positional (const expression & e)
+    {
+        switch (e.kind)
+        {
+        case op::number:    case op::add:   case op::sub:   case op::mul:
+        case op::div:       case op::mod:   case op::negate:
+
+            return true;
+
+        case op::function:
+
+            switch (e.fn)
+            {
+            case function::last:        case function::position:
+            case function::count:       case function::string_length:
+            case function::number:      case function::sum:
+            case function::floor:       case function::ceiling:
+            case function::round:
+
+                return true;
+
+            default:
+
+                break;
+            }
+            break;
+
+        default:
+
+            break;
+        }
+        return uses_position(e);
+    }
+
+    static bool uses_position (const expression & e)
+    {
+        if
+        (
+            e.kind == op::function &&
+            (e.fn == function::last || e.fn == function::position)
+        )
+        {
+            return true;
+        }
+        for (const auto & a : e.args)
+        {
+            if (uses_position(*a))
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     *  Replaces "descendant-or-self::node()/child::x[p]" with the
+     *  equivalent "descendant::x[p]" when no predicate uses positions.
+     */
+
+    static void fold_descendants (std::vector<xpath_step> & steps)
+    {
+        for (std::size_t i = 0; i + 1 < steps.size(); ++i)
+        {
+            xpath_step & s { steps[i] };
+            xpath_step & next { steps[i + 1] };
+            bool fold
+            {
+                s.a == axis::descendant_or_self &&
+                s.test == node_test::node && s.predicates.empty() &&
+                next.a == axis::child && ! next.positional
+            };
+            if (fold)
+            {
+                next.a = axis::descendant;
+                steps.erase(steps.begin() + std::ptrdiff_t(i));
+            }
+        }
+    }
+
+};          // class parser
+
+/*
+ * ------------------------------------------------------------------------
+ *  Values and conversions
+ * ------------------------------------------------------------------------
+ */
+
+struct value
+{
+    enum class type { nodeset, boolean, number, string };
+
+    type t { type::boolean };
+    hit_list nodes { };
+    bool b { false };
+    double n { 0.0 };
+    std::string s { };
+};
+
+value
+make_boolean (bool b)
+{
+    value result;
+    result.t = value::type::boolean;
+    result.b = b;
+    return result;
+}
+
+value
+make_number (double n)
+{
+    value result;
+    result.t = value::type::number;
+    result.n = n;
+    return result;
+}
+
+value
+make_string (std::string s)
+{
+    value result;
+    result.t = value::type::string;
+    result.s = std::move(s);
+    return result;
+}
+
+value
+make_nodeset (hit_list nodes)
+{
+    value result;
+    result.t = value::type::nodeset;
+    result.nodes = std::move(nodes);
+    return result;
+}
+
+const double c_nan { std::numeric_limits<double>::quiet_NaN() };
+
+/**
+ *  The XPath number() of a string, as libxml2 computes it:  optional
+ *  whitespace, an optional minus sign, a number as read by scan_number()
+ *  (which allows an exponent, and no digits at all if there is no point),
+ *  and optional whitespace.  Anything else is NaN.
+ */
+
+double
+string_to_number (const std::string & s)
+{
+    std::size_t i { 0 };
+    const std::size_t n { s.size() };
+    while (i < n && is_space(s[i]))
+        ++i;
+
+    if (i == n || (s[i] != '.' && s[i] != '-' && ! is_digit(s[i])))
+        return c_nan;
+
+    bool negative { s[i] == '-' };
+    if (negative)
+        ++i;
+
+    double result;
+    if (! scan_number(s, i, result))
+        return c_nan;
+
+    while (i < n && is_space(s[i]))
+        ++i;
+
+    if (i != n)
+        return c_nan;
+
+    return negative ? -result : result;
+}
+
+/**
+ *  The XPath string() of a number, as libxml2's xmlXPathFormatNumber()
+ *  writes it:  integers in the range of an int plainly, other numbers
+ *  from 1e-5 to 1e9 with 15 significant digits, and the rest in
+ *  exponential notation with 15 significant digits (e.g. "1e+20"), in
+ *  each case without trailing zeros in the fraction.
+ */
+
+std::string
+number_to_string (double d)
+{
+    if (std::isinf(d))
+        return d > 0 ? "Infinity" : "-Infinity";
+
+    if (std::isnan(d))
+        return "NaN";
+
+    if (d == 0)
+        return "0";                     /* also for negative zero           */
+
+    char buffer [100];
+    if (d > INT_MIN && d < INT_MAX && d == double(int(d)))
+    {
+        (void) std::snprintf(buffer, sizeof buffer, "%d", int(d));
+        return buffer;
+    }
+
+    const int digits { DBL_DIG };
+    double absolute { std::fabs(d) };
+    int size;
+    if (absolute > 1e9 || absolute < 1e-5)
+    {
+        size = std::snprintf
+        (
+            buffer, sizeof buffer, "%*.*e", digits + 5 + 1, digits - 1, d
+        );
+        while (size > 0 && buffer[size] != 'e')
+            --size;
+    }
+    else
+    {
+        int integer_place { int(std::log10(absolute)) };
+        int fraction_place
+        {
+            integer_place > 0 ?
+                digits - integer_place - 1 : digits - integer_place
+        };
+        size = std::snprintf
+        (
+            buffer, sizeof buffer, "%0.*f", fraction_place, d
+        );
+    }
+
+    std::string result { buffer };
+    std::size_t lead { result.find_first_not_of(' ') };
+    result.erase(0, lead);
+
+    std::size_t after { std::size_t(size) - lead };     /* the 'e' or end  */
+    std::size_t p { after };
+    while (p > 0 && result[p - 1] == '0')
+        --p;
+
+    if (p > 0 && result[p - 1] == '.')
+        --p;
+
+    result.erase(p, after - p);
+    return result;
+}
+
+/**
+ *  Appends the text of a node's content descendants.
+ */
+
+void
+append_text (const XMLNode & node, std::string & s)
+{
+    if (node.is_content())
+        s += node.content();
+
+    for (auto child : node.children())
+        append_text(*child, s);
+}
+
+/**
+ *  The UTF-8 characters of a string, each as a string.
+ */
+
+std::vector<std::string>
+characters (const std::string & s)
+{
+    std::vector<std::string> result;
+    for (std::size_t i = 0; i < s.size(); )
+    {
+        std::size_t len { 1 };
+        unsigned char c { static_cast<unsigned char>(s[i]) };
+        if (c >= 0xF0)
+            len = 4;
+        else if (c >= 0xE0)
+            len = 3;
+        else if (c >= 0xC0)
+            len = 2;
+
+        result.push_back(s.substr(i, len));
+        i += len;
+    }
+    return result;
+}
+
+/*
+ * ------------------------------------------------------------------------
+ *  Evaluator
+ * ------------------------------------------------------------------------
+ */
+
+struct context
+{
+    hit node;
+    std::size_t position;
+    std::size_t size;
+};
+
+inline bool
+is_document (const hit & h)
+{
+    return is_nullptr(h.node);
+}
+
+inline bool
+is_attribute (const hit & h)
+{
+    return not_nullptr(h.property);
+}
+
+inline bool
+same_hit (const hit & a, const hit & b)
+{
+    return a.node == b.node && a.property == b.property;
+}
+
+/**
+ *  Evaluates one expression against one tree.  Not shared between threads.
+ */
+
+class evaluator
+{
+
+private:
+
+    /*
+     * The document position and the parent of each node, built on first
+     * use.  The document node is position 0 and has no entry.
+     */
+
+    struct position_info
+    {
+        std::size_t order;
+        const XMLNode * parent;
+    };
+
+    using position_map = std::unordered_map<const XMLNode *, position_info>;
+
+    const XMLNode & m_root;
+    const std::string * m_text;         /* the expression, for errors       */
+    const XMLIndexList * m_indexes;
+    std::unique_ptr<position_map> m_positions;
+
+public:
+
+    evaluator
+    (
+        const XMLNode & root, const std::string & text,
+        const XMLIndexList * indexes
+    ) :
+        m_root      (root),
+        m_text      (&text),
+        m_indexes   (indexes),
+        m_positions ()
+    {
+        // No code
+    }
+
+    value evaluate (const expression & e, const context & ctx)
+    {
+        switch (e.kind)
+        {
+        case op::or_op:
+
+            return make_boolean
+            (
+                to_boolean(evaluate(*e.args[0], ctx)) ||
+                to_boolean(evaluate(*e.args[1], ctx))
+            );
+
+        case op::and_op:
+
+            return make_boolean
+            (
+                to_boolean(evaluate(*e.args[0], ctx)) &&
+                to_boolean(evaluate(*e.args[1], ctx))
+            );
+
+        case op::eq:    case op::ne:    case op::lt:
+        case op::le:    case op::gt:    case op::ge:
+
+            return make_boolean
+            (
+                compare
+                (
+                    e.kind, evaluate(*e.args[0], ctx), evaluate(*e.args[1], ctx)
+                )
+            );
+
+        case op::add:   case op::sub:   case op::mul:
+        case op::div:   case op::mod:
+
+            return make_number
+            (
+                arithmetic
+                (
+                    e.kind,
+                    to_number(evaluate(*e.args[0], ctx)),
+                    to_number(evaluate(*e.args[1], ctx))
+                )
+            );
+
+        case op::negate:
+
+            return make_number(-to_number(evaluate(*e.args[0], ctx)));
+
+        case op::union_op:
+
+            return make_union
+            (
+                evaluate(*e.args[0], ctx), evaluate(*e.args[1], ctx)
+            );
+
+        case op::literal:
+
+            return make_string(e.literal);
+
+        case op::number:
+
+            return make_number(e.number);
+
+        case op::function:
+
+            return call(e, ctx);
+
+        case op::path:
+
+            return make_nodeset(select_path(e, ctx.node));
+        }
+        return make_boolean(false);
+    }
+
+    [[noreturn]] void fail () const
+    {
+        throw XMLException("Invalid XPath: " + *m_text);
+    }
+
+private:
+
+    hit document () const
+    {
+        return hit { nullptr, nullptr };
+    }
+
+    /*
+     * Conversions
+     */
+
+    std::string string_value (const hit & h) const
+    {
+        if (is_attribute(h))
+            return h.property->value();
+
+        const XMLNode & node { is_document(h) ? m_root : *h.node };
+        if (node.is_content())
+            return node.content();
+
+        std::string result;
+        append_text(node, result);
+        return result;
+    }
+
+    std::string to_string (const value & v) const
+    {
+        switch (v.t)
+        {
+        case value::type::nodeset:
+
+            return v.nodes.empty() ? std::string() : string_value(v.nodes[0]);
+
+        case value::type::boolean:
+
+            return v.b ? "true" : "false";
+
+        case value::type::number:
+
+            return number_to_string(v.n);
+
+        case value::type::string:
+
+            return v.s;
+        }
+        return std::string();
+    }
+
+    double to_number (const value & v) const
+    {
+        switch (v.t)
+        {
+        case value::type::nodeset:
+        case value::type::string:
+
+            return string_to_number(to_string(v));
+
+        case value::type::boolean:
+
+            return v.b ? 1.0 : 0.0;
+
+        case value::type::number:
+
+            return v.n;
+        }
+        return c_nan;
+    }
+
+    static bool to_boolean (const value & v)
+    {
+        switch (v.t)
+        {
+        case value::type::nodeset:
+
+            return ! v.nodes.empty();
+
+        case value::type::boolean:
+
+            return v.b;
+
+        case value::type::number:
+
+            return v.n != 0 && ! std::isnan(v.n);
+
+        case value::type::string:
+
+            return ! v.s.empty();
+        }
+        return false;
+    }
+
+    /*
+     * Operators
+     */
+
+    static bool compare_numbers (op kind, double a, double b)
+    {
+        switch (kind)
+        {
+        case op::eq:    return a == b;
+        case op::ne:    return a != b;
+        case op::lt:    return a < b;
+        case op::le:    return a <= b;
+        case op::gt:    return a > b;
+        case op::ge:    return a >= b;
+        default:        return false;
+        }
+    }
+
+    static bool compare_strings
+    (
+        op kind, const std::string & a, const std::string & b
+    )
+    {
+        return kind == op::eq ? a == b : a != b;
+    }
+
+    static bool equality (op kind)
+    {
+        return kind == op::eq || kind == op::ne;
+    }
+
+    /**
+     *  Swaps the sides of a relational operator, for when the node-set is
+     *  on the right.
+     */
+
+    static op reversed (op kind)
+    {
+        switch (kind)
+        {
+        case op::lt:    return op::gt;
+        case op::le:    return op::ge;
+        case op::gt:    return op::lt;
+        case op::ge:    return op::le;
+        default:        return kind;
+        }
+    }
+
+    /**
+     *  Compares two values following XPath 1.0 section 3.4.
+     */
+
+    bool compare (op kind, const value & a, const value & b) const
+    {
+        using type = value::type;
+        if (a.t == type::nodeset && b.t == type::nodeset)
+        {
+            std::vector<std::string> right;
+            right.reserve(b.nodes.size());
+            for (const auto & h : b.nodes)
+                right.push_back(string_value(h));
+
+            for (const auto & h : a.nodes)
+            {
+                std::string left { string_value(h) };
+                for (const auto & r : right)
+                {
+                    bool match
+                    {
+                        equality(kind) ? compare_strings(kind, left, r) :
+                        compare_numbers
+                        (
+                            kind, string_to_number(left), string_to_number(r)
+                        )
+                    };
+                    if (match)
+                        return true;
+                }
+            }
+            return false;
+        }
+        if (a.t == type::nodeset || b.t == type::nodeset)
+        {
+            const value & set { a.t == type::nodeset ? a : b };
+            const value & other { a.t == type::nodeset ? b : a };
+            op k { a.t == type::nodeset ? kind : reversed(kind) };
+            if (other.t == type::boolean)
+                return compare_numbers(k, to_boolean(set), other.b);
+
+            for (const auto & h : set.nodes)
+            {
+                std::string s { string_value(h) };
+                bool numeric { other.t == type::number || ! equality(k) };
+                bool match
+                {
+                    numeric ?
+                        compare_numbers
+                        (
+                            k, string_to_number(s), to_number(other)
+                        ) :
+                        compare_strings(k, s, other.s)
+                };
+                if (match)
+                    return true;
+            }
+            return false;
+        }
+        if (equality(kind))
+        {
+            if (a.t == type::boolean || b.t == type::boolean)
+                return compare_numbers(kind, to_boolean(a), to_boolean(b));
+
+            if (a.t == type::number || b.t == type::number)
+                return compare_numbers(kind, to_number(a), to_number(b));
+
+            return compare_strings(kind, a.s, b.s);
+        }
+        return compare_numbers(kind, to_number(a), to_number(b));
+    }
+
+    static double arithmetic (op kind, double a, double b)
+    {
+        switch (kind)
+        {
+        case op::add:   return a + b;
+        case op::sub:   return a - b;
+        case op::mul:   return a * b;
+        case op::div:   return a / b;
+        case op::mod:   return std::fmod(a, b);
+        default:        return c_nan;
+        }
+    }
+
+    value make_union (value a, value b)
+    {
+        if (a.t != value::type::nodeset || b.t != value::type::nodeset)
+            fail();
+
+        a.nodes.insert(a.nodes.end(), b.nodes.begin(), b.nodes.end());
+        sort_unique(a.nodes);
+        return a;
+    }
+
+    /*
+     * Functions
+     */
+
+    const hit_list & nodeset_arg (const value & v) const
+    {
+        if (v.t != value::type::nodeset)
+            fail();
+
+        return v.nodes;
+    }
+
+    std::string string_arg
+    (
+        const expression & e, const context & ctx, std::size_t i
+    )
+    {
+        return to_string(evaluate(*e.args[i], ctx));
+    }
+
+    std::string name_of (const hit & h) const
+    {
+        if (is_attribute(h))
+            return h.property->name();
+
+        if (is_document(h) || h.node->is_content())
+            return std::string();
+
+        return h.node->name();
+    }
+
+    value call (const expression & e, const context & ctx)
+    {
+        std::size_t argc { e.args.size() };
+        switch (e.fn)
+        {
+        case function::last:
+
+            return make_number(double(ctx.size));
+
+        case function::position:
+
+            return make_number(double(ctx.position));
+
+        case function::count:
+
+            return make_number
+            (
+                double(nodeset_arg(evaluate(*e.args[0], ctx)).size())
+            );
+
+        case function::name:
+        case function::local_name:
+
+            if (argc == 0)
+                return make_string(name_of(ctx.node));
+            else
+            {
+                value v { evaluate(*e.args[0], ctx) };
+                const hit_list & nodes { nodeset_arg(v) };
+                return make_string
+                (
+                    nodes.empty() ? std::string() : name_of(nodes[0])
+                );
+            }
+
+        case function::string:
+
+            return make_string
+            (
+                argc == 0 ? string_value(ctx.node) : string_arg(e, ctx, 0)
+            );
+
+        case function::concat:
+        {
+            std::string result;
+            for (std::size_t i = 0; i < argc; ++i)
+                result += string_arg(e, ctx, i);
+
+            return make_string(std::move(result));
+        }
+
+        case function::starts_with:
+        {
+            std::string s { string_arg(e, ctx, 0) };
+            std::string prefix { string_arg(e, ctx, 1) };
+            return make_boolean(s.compare(0, prefix.size(), prefix) == 0);
+        }
+
+        case function::contains:
+        {
+            std::string s { string_arg(e, ctx, 0) };
+            std::string part { string_arg(e, ctx, 1) };
+            return make_boolean(s.find(part) != std::string::npos);
+        }
+
+        case function::substring_before:
+        {
+            std::string s { string_arg(e, ctx, 0) };
+            std::string part { string_arg(e, ctx, 1) };
+            std::size_t p { s.find(part) };
+            return make_string
+            (
+                p == std::string::npos ? std::string() : s.substr(0, p)
+            );
+        }
+
+        case function::substring_after:
+        {
+            std::string s { string_arg(e, ctx, 0) };
+            std::string part { string_arg(e, ctx, 1) };
+            std::size_t p { s.find(part) };
+            return make_string
+            (
+                p == std::string::npos ?
+                    std::string() : s.substr(p + part.size())
+            );
+        }
+
+        case function::substring:
+            return substring(e, ctx);
+
+        case function::string_length:
+        {
+            std::string s
+            {
+                argc == 0 ? string_value(ctx.node) : string_arg(e, ctx, 0)
+            };
+            return make_number(double(characters(s).size()));
+        }
+
+        case function::normalize_space:
+        {
+            std::string s
+            {
+                argc == 0 ? string_value(ctx.node) : string_arg(e, ctx, 0)
+            };
+            std::string result;
+            bool gap { false };
+            for (char c : s)
+            {
+                if (is_space(c))
+                {
+                    gap = ! result.empty();
+                }
+                else
+                {
+                    if (gap)
+                        result += ' ';
+
+                    result += c;
+                    gap = false;
+                }
+            }
+            return make_string(std::move(result));
+        }
+
+        case function::translate:
+            return translate(e, ctx);
+
+        case function::not_fn:
+
+            return make_boolean(! to_boolean(evaluate(*e.args[0], ctx)));
+
+        case function::true_fn:
+
+            return make_boolean(true);
+
+        case function::false_fn:
+
+            return make_boolean(false);
+
+        case function::boolean:
+
+            return make_boolean(to_boolean(evaluate(*e.args[0], ctx)));
+
+        case function::number:
+
+            return make_number
+            (
+                argc == 0 ?
+                    string_to_number(string_value(ctx.node)) :
+                    to_number(evaluate(*e.args[0], ctx))
+            );
+
+        case function::sum:
+        {
+            value v { evaluate(*e.args[0], ctx) };
+            double result { 0.0 };
+            for (const auto & h : nodeset_arg(v))
+                result += string_to_number(string_value(h));
+
+            return make_number(result);
+        }
+
+        case function::floor:
+
+            return make_number
+            (
+                std::floor(to_number(evaluate(*e.args[0], ctx)))
+            );
+
+        case function::ceiling:
+
+            return make_number
+            (
+                std::ceil(to_number(evaluate(*e.args[0], ctx)))
+            );
+
+        case function::round:
+        {
+            double d { to_number(evaluate(*e.args[0], ctx)) };
+            return make_number
+            (
+                std::isnan(d) || std::isinf(d) ? d : std::floor(d + 0.5)
+            );
+        }
+        }
+        return make_boolean(false);
+    }
+
+    /**
+     *  XPath substring(), which counts characters from 1 and rounds its
+     *  arguments.
+     */
+
+    value substring (const expression & e, const context & ctx)
+    {
+        std::vector<std::string> chars { characters(string_arg(e, ctx, 0)) };
+        auto xround = [] (double d)
+        {
+            return std::isnan(d) || std::isinf(d) ? d : std::floor(d + 0.5);
+        };
+        double start { xround(to_number(evaluate(*e.args[1], ctx))) };
+        double end
+        {
+            e.args.size() > 2 ?
+                start + xround(to_number(evaluate(*e.args[2], ctx))) :
+                std::numeric_limits<double>::infinity()
+        };
+        std::string result;
+        for (std::size_t i = 0; i < chars.size(); ++i)
+        {
+            double p { double(i + 1) };
+            if (p >= start && p < end)
+                result += chars[i];
+        }
+        return make_string(std::move(result));
+    }
+
+    value translate (const expression & e, const context & ctx)
+    {
+        std::vector<std::string> chars { characters(string_arg(e, ctx, 0)) };
+        std::vector<std::string> from { characters(string_arg(e, ctx, 1)) };
+        std::vector<std::string> to { characters(string_arg(e, ctx, 2)) };
+        std::string result;
+        for (const auto & c : chars)
+        {
+            auto it { std::find(from.begin(), from.end(), c) };
+            if (it == from.end())
+                result += c;
+            else
+            {
+                std::size_t i { std::size_t(it - from.begin()) };
+                if (i < to.size())
+                    result += to[i];
+            }
+        }
+        return make_string(std::move(result));
+    }
+
+    /*
+     * Location paths
+     */
+
+public:
+
+    hit_list select_path (const expression & e, const hit & start)
+    {
+        hit_list nodes { e.absolute ? document() : start };
+        for (const auto & s : e.steps)
+        {
+            nodes = apply_step(s, nodes);
+            if (nodes.empty())
+                break;
+        }
+        return nodes;
+    }
+
+    /*
+     * Batches of forward paths; see select_many().
+     */
+
+    using state = std::pair<std::size_t, std::size_t>;  /* path, step   */
+    using state_list = std::vector<state>;
+
+    void select_many
+    (
+        const std::vector<const expression *> & paths,
+        const std::vector<const std::string *> & texts,
+        std::vector<hit_list> & results
+    )
+    {
+        state_list start;
+        for (std::size_t q = 0; q < paths.size(); ++q)
+            start.push_back(state { q, 0 });
+
+        results.assign(paths.size(), hit_list());
+        visit(m_root, start, paths, texts, results);
+    }
+
+    /**
+     *  Tests a node against the states of its parent.  The states that
+     *  follow, for the node's children, are added to next, and the paths
+     *  that the node completes to done, each sorted without duplicates.
+     *  The predicates see only the node and what is below it.
+     */
+
+    void advance
+    (
+        const XMLNode & node, const state_list & active,
+        const std::vector<const expression *> & paths,
+        const std::vector<const std::string *> & texts,
+        state_list & next, std::vector<std::size_t> & done
+    )
+    {
+        for (const auto & st : active)
+        {
+            const std::vector<xpath_step> & steps { paths[st.first]->steps };
+            const xpath_step & s { steps[st.second] };
+            if (s.a == axis::descendant)
+                next.push_back(st);
+
+            if (! matches(s, node))
+                continue;
+
+            m_text = texts[st.first];
+            if (! passes(s, node))
+                continue;
+
+            std::size_t following { st.second + 1 };
+            if (following == steps.size())
+                done.push_back(st.first);
+            else if (steps[following].a == axis::attribute)
+                done.push_back(st.first);
+            else
+                next.push_back(state { st.first, following });
+        }
+        std::sort(done.begin(), done.end());
+        done.erase(std::unique(done.begin(), done.end()), done.end());
+        std::sort(next.begin(), next.end());
+        next.erase(std::unique(next.begin(), next.end()), next.end());
+    }
+
+    /**
+     *  Adds what a completed path selects at a node:  the node itself, or
+     *  its attributes that pass a final attribute step.
+     */
+
+    void record (const expression & path, const XMLNode & node, hit_list & out)
+    {
+        const xpath_step & last { path.steps.back() };
+        if (last.a == axis::attribute)
+            gather(last, hit { &node, nullptr }, out);
+        else
+            out.push_back(hit { &node, nullptr });
+    }
+
+private:
+
+    /**
+     *  Tests a node against the states of its parent, records the paths it
+     *  completes, and visits its children with the states that follow.
+     */
+
+    void visit
+    (
+        const XMLNode & node, const state_list & active,
+        const std::vector<const expression *> & paths,
+        const std::vector<const std::string *> & texts,
+        std::vector<hit_list> & results
+    )
+    {
+        state_list next;
+        std::vector<std::size_t> done;
+        advance(node, active, paths, texts, next, done);
+        for (auto q : done)
+            record(*paths[q], node, results[q]);
+
+        if (next.empty())
+            return;
+
+        for (auto child : node.children())
+            visit(*child, next, paths, texts, results);
+    }
+
+    /**
+     *  Applies a step's predicates, which do not use positions, to a node.
+     */
+
+    bool passes (const xpath_step & s, const XMLNode & node)
+    {
+        for (const auto & p : s.predicates)
+        {
+            context ctx { hit { &node, nullptr }, 1, 1 };
+            value v { evaluate(*p, ctx) };
+            bool keep
+            {
+                v.t == value::type::number ? v.n == 1.0 : to_boolean(v)
+            };
+            if (! keep)
+                return false;
+        }
+        return true;
+    }
+
+    static bool reverse_axis (axis a)
+    {
+        return a == axis::parent || a == axis::ancestor ||
+            a == axis::ancestor_or_self || a == axis::preceding_sibling;
+    }
+
+    hit_list apply_step (const xpath_step & s, const hit_list & input)
+    {
+        hit_list result;
+        hit_list candidates;
+        const XMLIndex::entry_list * entries { indexed(s) };
+        entry_map by_parent;
+        if (not_nullptr(entries) && s.a == axis::child && input.size() > 1)
+        {
+            for (const auto & e : *entries)
+                by_parent[e.parent].push_back(e);
+        }
+        for (const auto & c : input)
+        {
+            candidates.clear();
+            std::size_t first { 0 };    /* the index answers predicate 0    */
+            bool from_index
+            {
+                not_nullptr(entries) &&
+                gather(s, c, *entries, by_parent, candidates)
+            };
+            if (from_index)
+                first = 1;
+            else
+                gather(s, c, candidates);
+
+            for (std::size_t i = first; i < s.predicates.size(); ++i)
+            {
+                if (candidates.empty())
+                    break;
+
+                filter(*s.predicates[i], candidates);
+            }
+            result.insert(result.end(), candidates.begin(), candidates.end());
+        }
+
+        /*
+         * The attributes or selves of nodes in document order are in
+         * document order.  Otherwise, results from several context nodes
+         * can interleave, and reverse axes run backward.
+         */
+
+        bool ordered
+        {
+            input.size() <= 1 ?
+                ! reverse_axis(s.a) :
+                s.a == axis::attribute || s.a == axis::self
+        };
+        if (! ordered)
+            sort_unique(result);
+
+        return result;
+    }
+
+    void filter (const expression & predicate, hit_list & candidates)
+    {
+        std::size_t size { candidates.size() };
+        std::size_t kept { 0 };
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            context ctx { candidates[i], i + 1, size };
+            value v { evaluate(predicate, ctx) };
+            bool keep
+            {
+                v.t == value::type::number ?
+                    v.n == double(i + 1) : to_boolean(v)
+            };
+            if (keep)
+                candidates[kept++] = candidates[i];
+        }
+        candidates.resize(kept);
+    }
+
+    static bool matches (const xpath_step & s, const XMLNode & node)
+    {
+        switch (s.test)
+        {
+        case node_test::name:
+
+            return ! node.is_content() && node.atom() == s.name;
+
+        case node_test::any:
+
+            return ! node.is_content();
+
+        case node_test::text:
+
+            return node.is_content();
+
+        case node_test::node:
+
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     *  Tests a node found on a non-attribute axis.  The document node
+     *  matches only node(), and so does an attribute reached by self.
+     */
+
+    static bool matches (const xpath_step & s, const hit & h)
+    {
+        if (is_document(h) || is_attribute(h))
+            return s.test == node_test::node;
+
+        return matches(s, *h.node);
+    }
+
+    void add_if (const xpath_step & s, const hit & h, hit_list & out) const
+    {
+        if (matches(s, h))
+            out.push_back(h);
+    }
+
+    void descendants
+    (
+        const xpath_step & s, const XMLNode & node, hit_list & out
+    )
+    {
+        for (auto child : node.children())
+        {
+            if (matches(s, *child))
+                out.push_back(hit { child, nullptr });
+
+            descendants(s, *child, out);
+        }
+    }
+
+    /**
+     *  Appends the nodes along the step's axis from the context node that
+     *  pass its node test, in the order of the axis.
+     */
+
+    void gather (const xpath_step & s, const hit & c, hit_list & out)
+    {
+        switch (s.a)
+        {
+        case axis::child:
+
+            if (is_document(c))
+                add_if(s, hit { &m_root, nullptr }, out);
+            else if (! is_attribute(c))
+            {
+                for (auto child : c.node->children())
+                {
+                    if (matches(s, *child))
+                        out.push_back(hit { child, nullptr });
+                }
+            }
+            break;
+
+        case axis::descendant_or_self:
+
+            add_if(s, c, out);
+            /* FALL THROUGH */
+
+        case axis::descendant:
+
+            if (is_document(c))
+            {
+                add_if(s, hit { &m_root, nullptr }, out);
+                descendants(s, m_root, out);
+            }
+            else if (! is_attribute(c))
+                descendants(s, *c.node, out);
+
+            break;
+
+        case axis::self:
+
+            add_if(s, c, out);
+            break;
+
+        case axis::parent:
+
+            if (! is_document(c))
+                add_if(s, parent_of(c), out);
+
+            break;
+
+        case axis::ancestor_or_self:
+
+            add_if(s, c, out);
+            /* FALL THROUGH */
+
+        case axis::ancestor:
+
+            for (hit h = c; ! is_document(h); )
+            {
+                h = parent_of(h);
+                add_if(s, h, out);
+            }
+            break;
+
+        case axis::following_sibling:
+        case axis::preceding_sibling:
+
+            siblings(s, c, out);
+            break;
+
+        case axis::attribute:
+
+            if (! is_document(c) && ! is_attribute(c) && ! c.node->is_content())
+            {
+                for (auto prop : c.node->properties())
+                {
+                    bool match
+                    {
+                        s.test == node_test::node || s.test == node_test::any ||
+                        (s.test == node_test::name && prop->atom() == s.name)
+                    };
+                    if (match)
+                        out.push_back(hit { c.node, prop });
+                }
+            }
+            break;
+        }
+    }
+
+    /*
+     * Indexed steps
+     */
+
+    using entry_map = std::unordered_map
+    <
+        const XMLNode *, XMLIndex::entry_list
+    >;
+
+    /**
+     *  Returns the index entries for a step that can use an index, or null.
+     */
+
+    const XMLIndex::entry_list * indexed (const xpath_step & s) const
+    {
+        XMLName attribute;
+        const std::string * value { nullptr };
+        if (is_nullptr(m_indexes) || ! equality_step(s, attribute, value))
+            return nullptr;
+
+        const XMLIndex * x { find_index(m_indexes, s.name, attribute) };
+        return not_nullptr(x) ? &x->lookup(*value) : nullptr;
+    }
+
+    /**
+     *  Appends the indexed nodes along the step's axis from the context
+     *  node, which pass the node test and the first predicate.  Entries are
+     *  in document order.  The entries for each parent are given in
+     *  by_parent when there are several context nodes.
+     *
+     * \return
+     *      Returns false if the index cannot be used from this context node
+     *      (a descendant step below the root), and gather() must be used.
+     */
+
+    bool gather
+    (
+        const xpath_step & s, const hit & c,
+        const XMLIndex::entry_list & entries,
+        const entry_map & by_parent, hit_list & out
+    )
+    {
+        if (is_attribute(c))
+            return true;                /* an attribute has no children */
+
+        const XMLNode * parent { is_document(c) ? nullptr : c.node };
+        if (s.a == axis::child)
+        {
+            if (by_parent.empty())
+            {
+                for (const auto & e : entries)
+                {
+                    if (e.parent == parent)
+                        out.push_back(hit { e.node, nullptr });
+                }
+            }
+            else
+            {
+                auto it { by_parent.find(parent) };
+                if (it != by_parent.end())
+                {
+                    for (const auto & e : it->second)
+                        out.push_back(hit { e.node, nullptr });
+                }
+            }
+            return true;
+        }
+        if (is_document(c) || c.node == &m_root)
+        {
+            for (const auto & e : entries)
+            {
+                if (is_document(c) || not_nullptr(e.parent))
+                    out.push_back(hit { e.node, nullptr });
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void siblings (const xpath_step & s, const hit & c, hit_list & out)
+    {
+        if (is_document(c) || is_attribute(c))
+            return;
+
+        hit p { parent_of(c) };
+        if (is_document(p))
+            return;                     /* the root element is alone    */
+
+        const XMLNodeList & all { p.node->children() };
+        auto it { std::find(all.begin(), all.end(), c.node) };
+        if (it == all.end())
+            return;
+
+        if (s.a == axis::following_sibling)
+        {
+            for (++it; it != all.end(); ++it)
+            {
+                if (matches(s, **it))
+                    out.push_back(hit { *it, nullptr });
+            }
+        }
+        else
+        {
+            while (it != all.begin())
+            {
+                --it;
+                if (matches(s, **it))
+                    out.push_back(hit { *it, nullptr });
+            }
+        }
+    }
+
+    /*
+     * Document order
+     */
+
+    void index_positions (const XMLNode * node, const XMLNode * parent)
+    {
+        std::size_t order { m_positions->size() + 1 };
+        (*m_positions)[node] = position_info { order, parent };
+        for (auto child : node->children())
+            index_positions(child, node);
+    }
+
+    const position_map & positions ()
+    {
+        if (! m_positions)
+        {
+            m_positions = std::make_unique<position_map>();
+            index_positions(&m_root, nullptr);
+        }
+        return *m_positions;
+    }
+
+    hit parent_of (const hit & h)
+    {
+        if (is_attribute(h))
+            return hit { h.node, nullptr };
+
+        if (h.node == &m_root)
+            return document();
+
+        auto it { positions().find(h.node) };
+        if (it == positions().end() || is_nullptr(it->second.parent))
+            return document();
+
+        return hit { it->second.parent, nullptr };
+    }
+
+    /**
+     *  The sort key of a node:  its position in the document, then, for an
+     *  attribute, its position among the element's attributes.
+     */
+
+    std::pair<std::size_t, std::size_t> key (const hit & h)
+    {
+        if (is_document(h))
+            return std::make_pair(std::size_t(0), std::size_t(0));
+
+        std::size_t order { positions().at(h.node).order };
+        std::size_t attr { 0 };
+        if (is_attribute(h))
+        {
+            for (auto prop : h.node->properties())
+            {
+                ++attr;
+                if (prop == h.property)
+                    break;
+            }
+        }
+        return std::make_pair(order, attr);
+    }
+
+    void sort_unique (hit_list & nodes)
+    {
+        if (nodes.size() < 2)
+            return;
+
+        using keyed = std::pair<std::pair<std::size_t, std::size_t>, hit>;
+        std::vector<keyed> sorted;
+        sorted.reserve(nodes.size());
+        for (const auto & h : nodes)
+            sorted.emplace_back(key(h), h);
+
+        std::sort
+        (
+            sorted.begin(), sorted.end(),
+            [] (const keyed & a, const keyed & b) { return a.first < b.first; }
+        );
+        nodes.clear();
+        for (const auto & k : sorted)
+        {
+            if (nodes.empty() || ! same_hit(nodes.back(), k.second))
+                nodes.push_back(k.second);
+        }
+    }
+
+};          // class evaluator
+
+}           // namespace anonymous
+
+/**
+ * Class: XMLXPath
+ */
+
+XMLXPath::XMLXPath (const std::string & text, std::unique_ptr<expression> e) :
+    m_text          (text),
+    m_expression    (std::move(e)),
+    m_path          (),
+    m_forward       (forward_path(*m_expression)),
+    m_streamable    (stream_path(*m_expression))
+{
+    (void) simple_path(*m_expression, m_path);
+}
+
+XMLXPath::~XMLXPath () = default;
+
+/**
+ *  Parses an expression.
+ *
+ * \return
+ *      Returns null if the expression is outside the supported subset of
+ *      XPath, or is not valid XPath.  The caller should then evaluate it
+ *      with libxml2, which reports invalid expressions.
+ */
+
+std::unique_ptr<XMLXPath>
+XMLXPath::compile (const std::string & xpath)
+{
+    try
+    {
+        std::vector<token> tokens { tokenize(xpath) };
+        parser p { tokens };
+        expression_ptr e { p.parse() };
+        return std::unique_ptr<XMLXPath>(new XMLXPath(xpath, std::move(e)));
+    }
+    catch (const unsupported &)
+    {
+        return std::unique_ptr<XMLXPath>();
+    }
+}
+
+/**
+ *  Evaluates the expression with the given node as the document element.
+ *  The evaluation reads the tree but does not change it (apart from
+ *  converting lazy nodes).
+ *
+ * \param indexes
+ *      Optional indexes of the tree under root, built since its last
+ *      change.  Steps that can use one of them do.
+ *
+ * \throw
+ *      Throws XMLException if the result is not a node-set, or a function
+ *      was given a wrong argument type, as XMLTree::find() does.
+ *
+ * \return
+ *      Returns the selected nodes in document order.
+ */
+
+XMLXPath::hit_list
+XMLXPath::select (const XMLNode & root, const XMLIndexList * indexes) const
+{
+    if (simple())
+        return walk(root, indexes);
+
+    evaluator eval { root, m_text, indexes };
+    context ctx { hit { nullptr, nullptr }, 1, 1 };
+    value v { eval.evaluate(*m_expression, ctx) };
+    if (v.t != value::type::nodeset)
+        throw XMLException("Only nodeset result types are supported.");
+
+    return std::move(v.nodes);
+}
+
+/**
+ *  Evaluates several expressions in one depth-first pass over the tree
+ *  under the given root, instead of one pass each.  Expressions that are
+ *  not forward() are evaluated by select().
+ *
+ * \throw
+ *      Throws XMLException as select() does.
+ *
+ * \return
+ *      Returns the selected nodes of each expression, in the same order.
+ */
+
+std::vector<XMLXPath::hit_list>
+XMLXPath::select_many
+(
+    const std::vector<const XMLXPath *> & xpaths, const XMLNode & root
+)
+{
+    std::vector<hit_list> result(xpaths.size());
+    std::vector<const expression *> paths;
+    std::vector<const std::string *> texts;
+    std::vector<std::size_t> slots;
+    for (std::size_t i = 0; i < xpaths.size(); ++i)
+    {
+        if (xpaths[i]->forward())
+        {
+            paths.push_back(xpaths[i]->m_expression.get());
+            texts.push_back(&xpaths[i]->m_text);
+            slots.push_back(i);
+        }
+        else
+            result[i] = xpaths[i]->select(root);
+    }
+    if (! paths.empty())
+    {
+        evaluator eval { root, *texts.front(), nullptr };
+        std::vector<hit_list> found;
+        eval.select_many(paths, texts, found);
+        for (std::size_t j = 0; j < slots.size(); ++j)
+            result[slots[j]] = std::move(found[j]);
+    }
+    return result;
+}
+
+/**
+ * Class: XMLXPath::matcher
+ */
+
+/**
+ * \throw
+ *      Throws XMLException("XPath not supported for streaming: ...") if the
+ *      expression is not streamable().
+ */
+
+XMLXPath::matcher::matcher (const XMLXPath & xpath) :
+    m_xpath     (xpath)
+{
+    if (! xpath.streamable())
+    {
+        throw XMLException
+        (
+            "XPath not supported for streaming: " + xpath.text()
+        );
+    }
+}
+
+/**
+ *  Tests a node against the states of its parent.  The node has its name,
+ *  its attributes, or its content, but its children need not have been
+ *  read yet.
+ *
+ * \param node
+ *      The element or content node just read.
+ *
+ * \param active
+ *      The states of the node's parent, or start() for the document
+ *      element.
+ *
+ * \param [out] next
+ *      Set to the states for the node's children.  If it is empty, nothing
+ *      below the node can be selected.
+ *
+ * \return
+ *      Returns the node, or its selected attributes, if the node completes
+ *      the path; otherwise an empty list.
+ */
+
+XMLXPath::hit_list
+XMLXPath::matcher::step
+(
+    const XMLNode & node, const states & active, states & next
+) const
+{
+    const std::vector<const expression *> paths
+    {
+        m_xpath.m_expression.get()
+    };
+    const std::vector<const std::string *> texts { &m_xpath.m_text };
+    evaluator::state_list current;
+    current.reserve(active.size());
+    for (auto i : active)
+        current.push_back(evaluator::state { 0, i });
+
+    evaluator eval { node, m_xpath.m_text, nullptr };
+    evaluator::state_list following;
+    std::vector<std::size_t> done;
+    eval.advance(node, current, paths, texts, following, done);
+    next.clear();
+    for (const auto & st : following)
+        next.push_back(st.second);
+
+    hit_list result;
+    if (! done.empty())
+        eval.record(*paths.front(), node, result);
+
+    return result;
+}
+
+/**
+ *  True if select() would answer some step from one of the indexes.
+ */
+
+bool
+XMLXPath::uses_index (const XMLIndexList & indexes) const
+{
+    return xml66::uses_index(*m_expression, indexes);
+}
+
+/**
+ *  Follows a simple path down from the root.  The elements selected by a
+ *  step, taken from the children of the elements selected by the step
+ *  before in turn, are in document order.  A step with an indexed
+ *  attribute takes the index entries whose parents were selected.
+ */
+
+XMLXPath::hit_list
+XMLXPath::walk (const XMLNode & root, const XMLIndexList * indexes) const
+{
+    hit_list result;
+    const path_step & top { m_path.front() };
+    bool match
+    {
+        ! root.is_content() && root.atom() == top.name &&
+        (top.attribute.empty() || has_value(root, top.attribute, top.value))
+    };
+    if (! match)
+        return result;
+
+    std::vector<const XMLNode *> nodes { &root };
+    std::vector<const XMLNode *> next;
+    for (std::size_t i = 1; i < m_path.size() && ! nodes.empty(); ++i)
+    {
+        const path_step & s { m_path[i] };
+        const XMLIndex * x
+        {
+            s.attribute.empty() ?
+                nullptr : find_index(indexes, s.name, s.attribute)
+        };
+        next.clear();
+        if (not_nullptr(x))
+        {
+            std::unordered_set<const XMLNode *> parents
+            (
+                nodes.begin(), nodes.end()
+            );
+            for (const auto & e : x->lookup(s.value))
+            {
+                if (parents.count(e.parent) > 0)
+                    next.push_back(e.node);
+            }
+        }
+        else
+        {
+            auto take = [&s, &next] (const XMLNode * child)
+            {
+                bool keep
+                {
+                    ! child->is_content() && child->atom() == s.name &&
+                    (
+                        s.attribute.empty() ||
+                        has_value(*child, s.attribute, s.value)
+                    )
+                };
+                if (keep)
+                    next.push_back(child);
+            };
+            for (auto n : nodes)
+            {
+                if (n->children().size() >= XMLNode::c_child_index_threshold)
+                {
+                    for (auto child : n->children(s.name.str()))
+                        take(child);
+                }
+                else
+                {
+                    for (auto child : n->children())
+                        take(child);
+                }
+            }
+        }
+        nodes.swap(next);
+    }
+    result.reserve(nodes.size());
+    for (auto n : nodes)
+        result.push_back(hit { n, nullptr });
+
+    return result;
+}
+
+}           // namespace xml66
+
+/*
+ * xml66xpath.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -33,66 +33,228 @@
  * \library       xml66 library
  * \author        Chris Ahlstrom
  * \date          2026-02-20
- * \updates       2026-02-20
+ * \updates       2026-10-16
  * \version       $Revision$
  *
  */
 
+#include <algorithm>                    /* std::max(), std::find()          */
+#include <atomic>                       /* std::atomic<>                    */
+#include <climits>                      /* INT_MAX                          */
 #include <cstring>
+#include <functional>                   /* std::less<>                      */
 #include <iostream>
+#include <thread>                       /* std::thread                      */
 
+#include "xml66-config.h"               /* HAVE_SYS_MMAN_H                  */
+
+#if HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <libxml/SAX2.h>
+#include <libxml/xmlreader.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
 
 #include "cpp_types.hpp"                /* lib66's CSTR() etc. macros       */
 #include "utfcpp/utf8.h"                /* header in the utfcpp directory   */
+#include "xml/xml66stream.hpp"          /* xml66::XMLStream::read_node()    */
 #include "xml/xml66xx.hpp"              /* ditto, xml66::XML classes        */
 
+#if defined XML66_USE_NATIVE_PARSER
+#include "xml/xml66parser.hpp"          /* xml66::XMLParser native parser   */
+#endif
+
 xmlChar * xml_version = xmlCharStrdup("1.0");
 
 namespace xml66
 {
 
+XMLNode * readelement (xmlNodePtr);
 static XMLNode * readnode (xmlNodePtr);
-static void writenode (xmlDocPtr, XMLNode *, xmlNodePtr, int);
+
+/**
+ *  True if a string keeps its characters inside the string object (the
+ *  small-string buffer), so that destroying it frees nothing.
+ */
+
+static bool
+local_string (const std::string & s)
+{
+    const char * object { reinterpret_cast<const char *>(&s) };
+    std::less<const char *> before;
+    return ! before(s.data(), object) && before(s.data(), object + sizeof s);
+}
+static XMLNode * readstream (xmlTextReaderPtr);
+/*
+ * Maps the libxml2 nodes and attributes written by writenode() back to
+ * the XMLNodes and XMLProperties they were written from.
+ */
+
+using node_map = std::unordered_map<const void *, XMLNodeRef>;
+
+static void writenode (xmlDocPtr, XMLNode *, xmlNodePtr, int, node_map *);
+static xmlXPathObject * eval_nodeset
+(
+    xmlXPathContext * ctxt,
+    const XMLQuery & query
+);
 static XMLSharedNodeList * find_impl
 (
     xmlXPathContext * ctxt,
-    const std::string & xpath
+    const XMLQuery & query
 );
 
-static XMLNode *
-readnode (xmlNodePtr node)
+/**
+ *  Converts a libxml2 node, but not its children.  This is not static,
+ *  because XMLNode names it as a friend, for add_property_nocheck().
+ */
+
+XMLNode *
+readelement (xmlNodePtr node)
 {
     std::string name;
     std::string content;
-    xmlNodePtr child;
     if (not_nullptr(node->name))
         name = (const char*)node->name;
 
     XMLNode * tmp { new XMLNode(name) };
     xmlAttrPtr attr;
+    bool check { false };               /* see add_property_nocheck()       */
     for (attr = node->properties; attr; attr = attr->next)
     {
         content.clear();
         if (attr->children)
             content = (char*)attr->children->content;
 
-        tmp->set_property((const char *)(attr->name), content);
+        if (not_nullptr(attr->ns))
+            check = true;
+
+        if (check)
+            tmp->set_property((const char *)(attr->name), content);
+        else
+            tmp->add_property_nocheck((const char *)(attr->name), content);
     }
     if (node->content)
-        tmp->set_content((char *)(node->content));
+    {
+        /*
+         * libxml2's push parser does not normalize line ends in CDATA
+         * sections, comments, and processing instructions.  Elsewhere a
+         * '\r' cannot appear in these, so this affects only begin()/feed().
+         */
+
+        const char * text { (const char *)(node->content) };
+        bool raw
+        {
+            node->type == XML_CDATA_SECTION_NODE ||
+            node->type == XML_COMMENT_NODE || node->type == XML_PI_NODE
+        };
+        if (raw && not_nullptr(std::strchr(text, '\r')))
+        {
+            std::string normal;
+            for (const char * c = text; *c != 0; ++c)
+            {
+                if (*c != '\r')
+                    normal += *c;
+                else if (c[1] != '\n')
+                    normal += '\n';
+            }
+            tmp->set_content(normal);
+        }
+        else
+            tmp->set_content(text);
+    }
     else
         tmp->set_content(std::string());
 
-    for (child = node->children; child; child = child->next)
+    return tmp;
+}
+
+static XMLNode *
+readnode (xmlNodePtr node)
+{
+    XMLNode * tmp { readelement(node) };
+    for (xmlNodePtr child = node->children; child; child = child->next)
         tmp->add_child_nocopy(*readnode(child));
 
     return tmp;
 }
 
+/**
+ *  Builds the XMLNode tree directly from the events of an xmlTextReader.
+ *  The reader frees each libxml2 node once it moves past it, so only the
+ *  XMLNode tree is ever fully resident.
+ *
+ *  The nodes are made by XMLStream::read_node(), and so match what
+ *  readnode() produces from the equivalent xmlDoc.  Nodes outside the root
+ *  element are ignored.
+ *
+ * \return
+ *      Returns the root node, or nullptr if the document is not well-formed.
+ */
+
+static XMLNode *
+readstream (xmlTextReaderPtr reader)
+{
+    XMLNode * root { nullptr };
+    XMLNodeList stack;
+    int rc;
+    while ((rc = xmlTextReaderRead(reader)) == 1)
+    {
+        int type { xmlTextReaderNodeType(reader) };
+        if (type == XML_READER_TYPE_END_ELEMENT)
+        {
+            if (! stack.empty())
+                stack.pop_back();
+
+            continue;
+        }
+        if (type == XML_READER_TYPE_ELEMENT)
+        {
+            if (stack.empty() && not_nullptr(root))
+                continue;                   /* cannot happen, but be safe   */
+        }
+        else if (stack.empty())
+            continue;                       /* ignore prolog, epilog nodes  */
+
+        XMLNode * tmp { XMLStream::read_node(reader) };
+        if (is_nullptr(tmp))
+            continue;
+
+        if (stack.empty())
+            root = tmp;
+        else
+            stack.back()->add_child_nocopy(*tmp);
+
+        if (type == XML_READER_TYPE_ELEMENT)
+        {
+            if (xmlTextReaderIsEmptyElement(reader) != 1)
+                stack.push_back(tmp);
+        }
+    }
+    if (rc != 0)
+    {
+        delete root;
+        root = nullptr;
+    }
+    return root;
+}
+
+/**
+ *  Writes an XMLNode tree into an xmlDoc.  If refs is not null, each
+ *  libxml2 node and attribute made is recorded in it.
+ */
+
 static void
-writenode (xmlDocPtr doc, XMLNode * n, xmlNodePtr p, int root = 0)
+writenode
+(
+    xmlDocPtr doc, XMLNode * n, xmlNodePtr p,
+    int root = 0, node_map * refs = nullptr
+)
 {
     xmlNodePtr node { nullptr };
     if (root)
@@ -114,497 +276,2564 @@ writenode (xmlDocPtr doc, XMLNode * n, xmlNodePtr p, int root = 0)
         );
     }
 
+    if (not_nullptr(refs))
+        (*refs)[node] = XMLNodeRef{ n, nullptr };
+
     const XMLPropertyList & props { n->properties() };
     for (auto propiter : props)
     {
-        xmlSetProp
-        (
-            node, (const xmlChar *) CSTR(propiter->name()),
-            (const xmlChar *) CSTR(propiter->value())
-        );
+        xmlAttrPtr attr
+        {
+            xmlSetProp
+            (
+                node, (const xmlChar *) CSTR(propiter->name()),
+                (const xmlChar *) CSTR(propiter->value())
+            )
+        };
+        if (not_nullptr(refs))
+            (*refs)[attr] = XMLNodeRef{ n, propiter };
     }
 
     const XMLNodeList & children { n->children() };
     for (auto childiter : children)
     {
-        writenode(doc, childiter, node);
+        writenode(doc, childiter, node, 0, refs);
     }
 }
 
-/**
- * Class: XMLProperty
- *
- *      All functions are defined in the class header.
- */
+namespace
+{
 
 /**
- * Class: XMLTree
+ *  A read-only memory mapping of a file, made only if the file is a regular
+ *  file of at least the threshold size.  Compressed files are not mapped,
+ *  so that libxml2 can decompress them while reading.
  */
 
-XMLTree::XMLTree (const std::string & fn, bool validate) :
-    m_filename  (fn)
+class mapped_file
 {
-    read_internal(validate);
-}
 
-XMLTree::XMLTree (const XMLTree * from) :
-    m_filename      (from->filename()),
-    m_root          (new XMLNode(*from->root())),
-    m_doc           (xmlCopyDoc(from->m_doc, 1)),
-    m_compression   (from->compression())
-{
-    // no code
-}
+private:
 
-XMLTree::~XMLTree()
-{
-    if (not_nullptr(m_root))
-        delete m_root;
+    void * m_data { nullptr };
+    std::size_t m_size { 0 };
 
-    if (not_nullptr(m_doc))
-        xmlFreeDoc(m_doc);
-}
+public:
 
-int
-XMLTree::set_compression (int c)
-{
-    if (c > 9)
-        c = 9;
-    else if (c < 0)
-        c = 0;
+    mapped_file (const std::string & fn, std::size_t threshold);
+    ~mapped_file ();
 
-    m_compression = c;
-    return m_compression;
-}
+    mapped_file (const mapped_file &) = delete;
+    mapped_file & operator = (const mapped_file &) = delete;
 
-bool
-XMLTree::read_internal (bool validate)
-{
-    if (not_nullptr(m_root))
+    bool mapped () const
     {
-        delete m_root;
-        m_root = nullptr;
+        return not_nullptr(m_data);
     }
-    if (m_doc)
+
+    const char * data () const
     {
-        xmlFreeDoc(m_doc);
-        m_doc = nullptr;
+        return static_cast<const char *>(m_data);
     }
 
-    /*
-     * Calling this prevents libxml2 from treating whitespace as active
-     * nodes. It needs to be called before we create a parser context.
-     */
+    int size () const
+    {
+        return int(m_size);
+    }
 
-    xmlKeepBlanksDefault(0);
+};
 
-    xmlParserCtxtPtr ctxt { xmlNewParserCtxt() };   /* new parser context   */
-    if (ctxt == NULL)
-        return false;
+#if HAVE_SYS_MMAN_H
 
-    /*
-     * Parse the file, activating the DTD validation option.
-     */
+mapped_file::mapped_file (const std::string & fn, std::size_t threshold)
+{
+    if (threshold == 0)
+        return;
 
-    if (validate)
-    {
-        m_doc = xmlCtxtReadFile
-        (
-            ctxt, CSTR(m_filename), NULL, XML_PARSE_DTDVALID
-        );
-    }
-    else
-    {
-        m_doc = xmlCtxtReadFile
-        (
-            ctxt, CSTR(m_filename), NULL, XML_PARSE_HUGE
-        );
-    }
+    int fd { ::open(CSTR(fn), O_RDONLY | O_CLOEXEC) };
+    if (fd < 0)
+        return;
 
-    if (m_doc == nullptr)               /* check if parsing succeeded       */
-    {
-        xmlFreeParserCtxt(ctxt);
-        return false;
-    }
-    else                                /* check if validation succeeded    */
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
     {
-        if (validate && ! ctxt->valid)  // == 0)
+        std::size_t sz { std::size_t(st.st_size) };
+        if (sz >= threshold && sz > 0 && sz <= std::size_t(INT_MAX))
         {
-            xmlFreeParserCtxt(ctxt);
-            throw XMLException("Failed to validate document " + m_filename);
+            void * p { ::mmap(NULL, sz, PROT_READ, MAP_PRIVATE, fd, 0) };
+            if (p != MAP_FAILED)
+            {
+                const unsigned char * c { static_cast<unsigned char *>(p) };
+                if (sz >= 2 && c[0] == 0x1f && c[1] == 0x8b)
+                {
+                    ::munmap(p, sz);            /* gzip, let libxml2 read it */
+                }
+                else
+                {
+                    (void) ::posix_madvise(p, sz, POSIX_MADV_SEQUENTIAL);
+                    m_data = p;
+                    m_size = sz;
+                }
+            }
         }
     }
-    m_root = readnode(xmlDocGetRootElement(m_doc));
-    xmlFreeParserCtxt(ctxt);            /* free up the parser context       */
-    return true;
+    ::close(fd);
 }
 
-bool
-XMLTree::read_buffer (char const * buffer, bool to_tree_doc)
+mapped_file::~mapped_file ()
 {
-    m_filename.clear();
-    delete m_root;
-    m_root = nullptr;
-
-    /*
-     * Calling this prevents libxml2 from treating whitespace as active.
-     */
+    if (not_nullptr(m_data))
+        ::munmap(m_data, m_size);
+}
 
-    xmlKeepBlanksDefault(0);
+#else
 
-    xmlDocPtr doc { xmlParseMemory(buffer, std::strlen(buffer)) };
-    if (is_nullptr(doc))
-        return false;
+mapped_file::mapped_file (const std::string &, std::size_t)
+{
+    // no code, always use buffered I/O
+}
 
-    m_root = readnode(xmlDocGetRootElement(doc));
-    if (to_tree_doc)
-    {
-        if (m_doc)
-            xmlFreeDoc(m_doc);
+mapped_file::~mapped_file ()
+{
+    // no code
+}
 
-        m_doc = doc;
-    }
-    else
-        xmlFreeDoc(doc);
+#endif
 
-    return true;
-}
+/**
+ *  Reads a whole file into a string, for parsing files too small to map.
+ */
 
 bool
-XMLTree::write () const
+load_file (const std::string & fn, std::string & text)
 {
-    // XMLNodeList children;
-
-    xmlKeepBlanksDefault(0);
+    std::FILE * fp { std::fopen(CSTR(fn), "rb") };
+    if (is_nullptr(fp))
+        return false;
 
-    xmlDocPtr doc { xmlNewDoc(xml_version) };
-    xmlSetDocCompressMode(doc, m_compression);
-    writenode(doc, m_root, doc->children, 1);
+    char buffer[64 * 1024];
+    std::size_t count;
+    text.clear();
+    while ((count = std::fread(buffer, 1, sizeof buffer, fp)) > 0)
+        text.append(buffer, count);
 
-    int result { xmlSaveFormatFileEnc(CSTR(m_filename), doc, "UTF-8", 1) };
+    bool result { std::ferror(fp) == 0 };
+    std::fclose(fp);
+    return result;
+}
 
-#if defined PLATFORM_DEBUG
+}               // namespace anonymous
 
-    if (result == (-1))
-    {
-        const xmlError * xerr = xmlGetLastError ();
-        if (is_nullptr(xerr))
-        {
-            std::cerr
-                << "unknown XML error during xmlSaveFormatFileEnc()."
-                << std::endl
-                ;
-        }
-        else
-        {
-            std::cerr << "xmlSaveFormatFileEnc: error"
-                << " domain: " << xerr->domain
-                << " code: " << xerr->code
-                << " msg: " << xerr->message
-                << std::endl
-                ;
-        }
-    }
+/**
+ * Class: XMLEdits
+ */
 
-#endif
+thread_local int XMLEdits::s_quiet { 0 };
+thread_local XMLEdits * XMLEdits::s_current { nullptr };
 
-    xmlFreeDoc(doc);
-    if (result == (-1))
-        return false;
+/**
+ *  Reports that a property of a node was added, changed, or removed.
+ *
+ * \param before
+ *      The old value, or null if the property was added.
+ *
+ * \param after
+ *      The new value, or null if the property was removed.
+ */
 
-    return true;
+void
+XMLEdits::property
+(
+    XMLNode & node, XMLName name,
+    const std::string * before, const std::string * after
+)
+{
+    (void) m_count.fetch_add(1, std::memory_order_acq_rel);
+    m_tree.property_edited(node, name, before, after);
 }
 
 void
-XMLTree::debug (FILE * out) const
+XMLEdits::content (XMLNode & node)
 {
-#if defined XML66_DEBUG_ENABLED
-
-    // XMLNodeList children;
+    (void) m_count.fetch_add(1, std::memory_order_acq_rel);
+    m_tree.content_edited(node);
+}
 
-    xmlKeepBlanksDefault(0);
+/**
+ *  Reports a child appended to a node, after it has joined the tree.
+ */
 
-    xmlDocPtr doc = xmlNewDoc(xml_version);
-    xmlSetDocCompressMode(doc, m_compression);
-    writenode(doc, m_root, doc->children, 1);
-    xmlDebugDumpDocument(out, doc);
-    xmlFreeDoc(doc);
-#else
-    (void) out;
-#endif
+void
+XMLEdits::added (XMLNode & parent, XMLNode & child)
+{
+    (void) m_count.fetch_add(1, std::memory_order_acq_rel);
+    m_tree.child_added(parent, child);
 }
 
-const std::string &
-XMLTree::write_buffer() const
+/**
+ *  Reports a child about to be removed from a node, while it is still
+ *  there.
+ */
+
+void
+XMLEdits::removing (XMLNode & /* parent */, XMLNode & child)
 {
-    // XMLNodeList children;
+    (void) m_count.fetch_add(1, std::memory_order_acq_rel);
+    m_tree.child_removing(child);
+}
 
-    static std::string result;
-    char * ptr;
-    int len;
+/**
+ *  Reports a node whose name, content, properties, and children were all
+ *  replaced, by assignment.
+ */
 
-    xmlKeepBlanksDefault(0);
+void
+XMLEdits::replaced (XMLNode & node)
+{
+    (void) m_count.fetch_add(1, std::memory_order_acq_rel);
+    m_tree.node_replaced(node);
+}
 
-    xmlDocPtr doc = xmlNewDoc(xml_version);
-    xmlSetDocCompressMode(doc, m_compression);
-    writenode(doc, m_root, doc->children, 1);
-    xmlDocDumpMemory(doc, (xmlChar **) &ptr, &len);
-    xmlFreeDoc(doc);
-    result = ptr;
-    free(ptr);
-    return result;
+/**
+ * Class: XMLProperty
+ */
+
+/**
+ *  Changes the value, and reports the change if the property belongs to a
+ *  node of a tree.
+ */
+
+const std::string &
+XMLProperty::set_value (const std::string & v)
+{
+    XMLEdits * edits { not_nullptr(m_owner) ? m_owner->m_edits : nullptr };
+    if (! XMLEdits::tracked(edits))
+        return m_value = v;
+
+    std::string before { std::move(m_value) };
+    m_value = v;
+    edits->property(*m_owner, m_name, &before, &m_value);
+    return m_value;
 }
 
 /**
- * Class: XMLNode
+ * Class: XMLPropertyList
  */
 
-static const int PROPERTY_RESERVE_COUNT { 16 };
+/**
+ *  Appends a property.  The caller has checked that the name is not
+ *  already present.  The slot of an erased property is reused first;
+ *  otherwise the first property allocates the block, and those past it go
+ *  in the overflow deque.
+ *
+ * \param arena
+ *      If not null, the block is taken from this arena instead of the
+ *      heap.  XMLNode passes the current arena only for a node that was
+ *      itself allocated in it, so the block never outlives its arena.
+ *
+ * \return
+ *      Returns the new property, whose address does not change until it is
+ *      erased or the list is cleared.
+ */
 
-XMLNode::XMLNode (const std::string & n) :
-    m_name(n)
+XMLProperty *
+XMLPropertyList::push_back
+(
+    XMLName name, const std::string & value, XMLArena * arena
+)
 {
-    m_proplist.reserve(PROPERTY_RESERVE_COUNT);
+    index_type index;
+    slot * result;
+    if (m_free != c_none)
+    {
+        index = m_free;
+        result = &at(index);
+        m_free = result->next;
+        result->next = c_none;
+        result->property = XMLProperty(name, value);
+    }
+    else
+    {
+        index = m_used;
+        if (index < c_block_count)
+        {
+            if (is_nullptr(m_block))
+            {
+                std::size_t bytes { c_block_count * sizeof(slot) };
+                m_block_in_arena = not_nullptr(arena);
+                m_block = static_cast<slot *>
+                (
+                    m_block_in_arena ?
+                        arena->allocate(bytes, alignof(slot)) :
+                        ::operator new(bytes)
+                );
+            }
+            result = ::new (m_block + index) slot(name, value);
+        }
+        else
+        {
+            if (! m_overflow)
+                m_overflow = std::make_unique<overflow_list>();
+
+            result = &m_overflow->emplace_back(name, value);
+        }
+        ++m_used;
+    }
+    if (m_tail == c_none)
+        m_head = index;
+    else
+        at(m_tail).next = index;
+
+    m_tail = index;
+    ++m_live;
+    return &result->property;
 }
 
-XMLNode::XMLNode (const std::string & n, const std::string & c) :
-    m_name          (n),
-    m_is_content    (true),
-    m_content       (c)
+/**
+ *  Unlinks a property and puts its slot on the free list.  Its value is
+ *  dropped now; push_back() will reuse the slot.
+ *
+ * \return
+ *      Returns an iterator to the next property.
+ */
+
+XMLPropertyList::iterator
+XMLPropertyList::erase (iterator pos)
 {
-    m_proplist.reserve(PROPERTY_RESERVE_COUNT);
+    index_type index { pos.m_index };
+    slot & s { at(index) };
+    index_type following { s.next };
+    if (pos.m_prior == c_none)
+        m_head = following;
+    else
+        at(pos.m_prior).next = following;
+
+    if (m_tail == index)
+        m_tail = pos.m_prior;
+
+    s.property = XMLProperty(s.property.atom(), std::string());
+    s.next = m_free;
+    m_free = index;
+    --m_live;
+    return iterator(this, following, pos.m_prior);
 }
 
-XMLNode::XMLNode (const XMLNode & from)
+/**
+ *  Moves the properties of another list, leaving it empty.  A heap block
+ *  and the overflow deque are taken over, so pointers to those properties
+ *  remain valid.  A block in an arena is moved into a new heap block
+ *  instead, as this list may outlive the arena; pointers into it are
+ *  invalidated, and the allocation can throw std::bad_alloc, so these
+ *  moves are not noexcept.
+ */
+
+XMLPropertyList::XMLPropertyList (XMLPropertyList && from)
 {
-    m_proplist.reserve(PROPERTY_RESERVE_COUNT);
-    *this = from;
+    *this = std::move(from);
 }
 
-XMLNode &
-XMLNode::operator = (const XMLNode & from)
+XMLPropertyList &
+XMLPropertyList::operator = (XMLPropertyList && from)
 {
     if (this != &from)
     {
-        clear_lists ();
-        m_name = from.name ();
-        set_content(from.content());
-
-        const XMLPropertyList & props { from.properties () };
-        for (auto propiter : props)
-            set_property(CSTR(propiter->name()), propiter->value());
+        clear();
+        if (from.m_block_in_arena)
+        {
+            std::size_t bytes { c_block_count * sizeof(slot) };
+            m_block = static_cast<slot *>(::operator new(bytes));
+            index_type count
+            {
+                std::min(from.m_used, index_type(c_block_count))
+            };
+            for (index_type i = 0; i < count; ++i)
+                (void) ::new (m_block + i) slot(std::move(from.m_block[i]));
+        }
+        else
+        {
+            m_block = from.m_block;
+            from.m_block = nullptr;
+        }
+        m_overflow = std::move(from.m_overflow);
+        m_used = from.m_used;
+        m_live = from.m_live;
+        m_head = from.m_head;
+        m_tail = from.m_tail;
+        m_free = from.m_free;
+        from.clear();
+    }
+    return *this;
+}
+
+void
+XMLPropertyList::clear ()
+{
+    if (not_nullptr(m_block))
+    {
+        index_type count { std::min(m_used, index_type(c_block_count)) };
+        for (index_type i = 0; i < count; ++i)
+            m_block[i].~slot();
+
+        if (! m_block_in_arena)
+            ::operator delete(m_block);
+
+        m_block = nullptr;
+    }
+    m_overflow.reset();
+    m_used = m_live = 0;
+    m_head = m_tail = m_free = c_none;
+    m_block_in_arena = false;
+}
+
+/**
+ *  True if any property still holds heap memory:  a block or overflow list
+ *  not in an arena, or a value too long to be stored inside its string.
+ */
+
+bool
+XMLPropertyList::holds_heap () const
+{
+    if (m_overflow || (not_nullptr(m_block) && ! m_block_in_arena))
+        return true;
+
+    for (index_type i = 0; i < m_used; ++i)
+    {
+        if (! local_string(at(i).property.value()))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Class: XMLTree
+ */
+
+XMLTree::XMLTree (const std::string & fn, bool validate) :
+    m_filename  (fn)
+{
+    read_internal(validate);
+}
+
+XMLTree::XMLTree (const std::string & fn, ingest mode) :
+    m_filename  (fn),
+    m_ingest    (mode)
+{
+    read_internal(false);
+}
+
+XMLTree::XMLTree (const XMLTree * from) :
+    m_filename      (from->filename()),
+    m_doc
+    (
+        from->doc_current() ? xmlCopyDoc(from->m_doc, 1) : nullptr
+    ),
+    m_compression   (from->compression())
+{
+    XMLEdits::scope copying { &m_edits };
+    m_root = new XMLNode(*from->root());
+}
+
+/**
+ *  Reads many files concurrently.  Each worker thread takes the next path
+ *  and reads it into its own XMLTree, with its own libxml2 parser context;
+ *  no global libxml2 settings are changed.
+ *
+ * \param paths
+ *      The files to read.
+ *
+ * \param threads
+ *      The number of worker threads.  Zero means one per hardware thread.
+ *      No more threads than paths are started.
+ *
+ * \param mode
+ *      The ingest mode for each tree.  Validation is not done.
+ *
+ * \return
+ *      Returns one tree per path, in the same order.  A tree whose file
+ *      could not be read has a null root().
+ */
+
+XMLTreeList
+XMLTree::load_all
+(
+    const std::vector<std::string> & paths,
+    unsigned threads,
+    ingest mode
+)
+{
+    XMLTreeList result(paths.size());
+    if (paths.empty())
+        return result;
+
+    xmlInitParser();                    /* must precede threaded parsing    */
+    if (threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    if (threads > paths.size())
+        threads = unsigned(paths.size());
+
+    std::atomic<std::size_t> next { 0 };
+    auto worker = [&] ()
+    {
+        for (;;)
+        {
+            std::size_t i { next.fetch_add(1) };
+            if (i >= paths.size())
+                break;
+
+            XMLTreePtr tree { std::make_shared<XMLTree>() };
+            tree->set_filename(paths[i]);
+            tree->set_ingest_mode(mode);
+            try
+            {
+                (void) tree->read();
+            }
+            catch (const std::exception &)
+            {
+                tree->clear_root();
+            }
+            result[i] = tree;
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(worker);
+
+    worker();                           /* the caller's thread works too    */
+    for (auto & t : pool)
+        t.join();
+
+    return result;
+}
+
+XMLTree::~XMLTree()
+{
+    if (not_nullptr(m_root))
+        delete m_root;
+
+    if (not_nullptr(m_doc))
+        xmlFreeDoc(m_doc);
+
+    push_reset();
+}
+
+int
+XMLTree::set_compression (int c)
+{
+    if (c > 9)
+        c = 9;
+    else if (c < 0)
+        c = 0;
+
+    m_compression = c;
+    return m_compression;
+}
+
+/**
+ *  Deletes the root node and, in arena mode, releases the arena for the
+ *  next read.  The arena is created on the first read in arena mode, and
+ *  dropped by the first read after arena mode is turned off.
+ */
+
+void
+XMLTree::clear_root ()
+{
+    if (m_arena)
+        release_nodes(m_root);
+    else
+        delete m_root;
+
+    m_root = nullptr;
+    drop_caches();
+    if (m_use_arena)
+    {
+        if (m_arena)
+            m_arena->release();
+        else
+            m_arena = std::make_unique<XMLArena>();
+    }
+    else
+        m_arena.reset();
+}
+
+/**
+ *  Replaces the root node.  The new root and its descendants become part
+ *  of this tree, and the old root, which the caller now owns, leaves it.
+ */
+
+XMLNode *
+XMLTree::set_root (XMLNode * n)
+{
+    (void) m_edits.m_count.fetch_add(1, std::memory_order_acq_rel);
+    if (not_nullptr(m_root) && m_root != n)
+        m_root->join(nullptr);
+
+    if (not_nullptr(n))
+        n->join(&m_edits);
+
+    drop_caches();
+    return m_root = n;
+}
+
+/**
+ *  Tears down a tree whose nodes are mostly in the arena, in one pass
+ *  without recursion.  The children are taken from each node first.  An
+ *  arena node that holds no heap memory, such as a short text node or an
+ *  empty element with short attribute values, is left for the arena to
+ *  reclaim, without running its destructor.  Other arena nodes are
+ *  destroyed in place, and heap nodes (added after the read) are deleted.
+ */
+
+void
+XMLTree::release_nodes (XMLNode * root)
+{
+    XMLNodeList pending;
+    if (not_nullptr(root))
+        pending.push_back(root);
+
+    while (! pending.empty())
+    {
+        XMLNode * node { pending.back() };
+        pending.pop_back();
+        pending.insert
+        (
+            pending.end(), node->m_children.begin(), node->m_children.end()
+        );
+        node->m_children.clear();
+        if (! node->m_in_arena || node->holds_heap())
+            delete node;                /* frees only heap nodes themselves */
+    }
+}
+
+bool
+XMLTree::read_internal (bool validate)
+{
+    clear_root();
+    if (m_doc)
+    {
+        xmlFreeDoc(m_doc);
+        m_doc = nullptr;
+    }
+
+    XMLArena::scope use_arena { m_arena.get() };
+    XMLEdits::scope reading { &m_edits };
+    if (m_ingest == ingest::native && ! validate)
+    {
+        mapped_file mf { m_filename, m_mmap_threshold };
+        if (mf.mapped())
+        {
+            if (read_native(mf.data(), std::size_t(mf.size())))
+                return true;
+        }
+        else
+        {
+            std::string text;
+            if (load_file(m_filename, text))
+            {
+                if (read_native(text.data(), text.size()))
+                    return true;
+            }
+        }
+        return read_streaming();
+    }
+    if (m_ingest == ingest::streaming && ! validate)
+        return read_streaming();
+
+    XMLParserPool::lease parser { parser_pool() };
+    xmlParserCtxtPtr ctxt { parser.get() };         /* borrowed context     */
+    if (ctxt == NULL)
+        return false;
+
+    /*
+     * Parse the file, activating the DTD validation option if specified.
+     * Large files are parsed from a memory mapping.  XML_PARSE_NOBLANKS
+     * keeps libxml2 from treating whitespace as active nodes; unlike the
+     * global xmlKeepBlanksDefault(0), it is safe to use from any thread.
+     * The xmlDoc is kept, so it must not share the pooled context's
+     * dictionary (XML_PARSE_NODICT).
+     */
+
+    int options { validate ? XML_PARSE_DTDVALID : XML_PARSE_HUGE };
+    options |= XML_PARSE_NOBLANKS | XML_PARSE_NODICT;
+    mapped_file mf { m_filename, m_mmap_threshold };
+    if (mf.mapped())
+    {
+        m_doc = xmlCtxtReadMemory
+        (
+            ctxt, mf.data(), mf.size(), CSTR(m_filename), NULL, options
+        );
+    }
+    else
+        m_doc = xmlCtxtReadFile(ctxt, CSTR(m_filename), NULL, options);
+
+    if (m_doc == nullptr)               /* check if parsing succeeded       */
+    {
+        return false;
+    }
+    else                                /* check if validation succeeded    */
+    {
+        if (validate && ! ctxt->valid)  // == 0)
+            throw XMLException("Failed to validate document " + m_filename);
+    }
+    if (m_ingest == ingest::lazy)
+        m_root = new XMLNode(xmlDocGetRootElement(m_doc));
+    else
+        m_root = readnode(xmlDocGetRootElement(m_doc));
+
+    m_doc_edits = m_edits.count();
+    return true;                        /* the lease returns the context    */
+}
+
+/**
+ *  Reads m_filename with an xmlTextReader, building m_root without keeping
+ *  an xmlDoc.  XML_PARSE_NOBLANKS replaces the global xmlKeepBlanksDefault()
+ *  setting.
+ */
+
+bool
+XMLTree::read_streaming ()
+{
+    const int options { XML_PARSE_NOBLANKS | XML_PARSE_HUGE };
+    mapped_file mf { m_filename, m_mmap_threshold };
+    xmlTextReaderPtr reader
+    {
+        mf.mapped() ?
+            xmlReaderForMemory
+            (
+                mf.data(), mf.size(), CSTR(m_filename), NULL, options
+            ) :
+            xmlReaderForFile(CSTR(m_filename), NULL, options)
+    };
+    if (is_nullptr(reader))
+        return false;
+
+    m_root = readstream(reader);
+    xmlFreeTextReader(reader);
+    return not_nullptr(m_root);
+}
+
+/**
+ *  Parses text with the native XMLParser, if it was built.
+ *
+ * \return
+ *      Returns false if the parser is not available or could not handle
+ *      the text, in which case the caller falls back to libxml2.
+ */
+
+bool
+XMLTree::read_native (const char * buffer, std::size_t len)
+{
+#if defined XML66_USE_NATIVE_PARSER
+    XMLParser parser { buffer, len };
+    m_root = parser.parse();
+    return not_nullptr(m_root);
+#else
+    (void) buffer;
+    (void) len;
+    return false;
+#endif
+}
+
+bool
+XMLTree::read_buffer (char const * buffer, bool to_tree_doc)
+{
+    return read_buffer_n(buffer, std::strlen(buffer), to_tree_doc);
+}
+
+/**
+ *  Parses a buffer that need not be NUL-terminated.  The parser context is
+ *  borrowed from parser_pool(), so repeated parses do not rebuild it or
+ *  its dictionary.  XML_PARSE_NOBLANKS replaces the global
+ *  xmlKeepBlanksDefault() setting.
+ *
+ *  This is not an overload of read_buffer():  with read_buffer(buffer,
+ *  to_tree_doc), a call with an int or long length would be ambiguous.
+ *
+ * \param buffer
+ *      The start of the XML text.
+ *
+ * \param len
+ *      The number of bytes of XML text.
+ *
+ * \param to_tree_doc
+ *      If true, the parsed xmlDoc is kept for use by find().
+ *
+ * \return
+ *      Returns true if the buffer was parsed.
+ */
+
+bool
+XMLTree::read_buffer_n
+(
+    char const * buffer, std::size_t len, bool to_tree_doc
+)
+{
+    m_filename.clear();
+    clear_root();
+
+    XMLArena::scope use_arena { m_arena.get() };
+    XMLEdits::scope reading { &m_edits };
+    if (m_ingest == ingest::native && ! to_tree_doc)
+    {
+        if (read_native(buffer, len))
+            return true;
+    }
+    if (len > std::size_t(INT_MAX))
+        return false;
+
+    XMLParserPool::lease parser { parser_pool() };
+    if (is_nullptr(parser.get()))
+        return false;
+
+    int options { XML_PARSE_NOBLANKS | XML_PARSE_HUGE };
+    if (to_tree_doc)
+        options |= XML_PARSE_NODICT;    /* the kept doc must not share it   */
+
+    xmlDocPtr doc
+    {
+        xmlCtxtReadMemory(parser.get(), buffer, int(len), NULL, NULL, options)
+    };
+    if (is_nullptr(doc))
+        return false;
+
+    if (to_tree_doc)
+    {
+        if (m_doc)
+            xmlFreeDoc(m_doc);
+
+        m_doc = doc;
+        m_doc_edits = m_edits.count();
+        if (m_ingest == ingest::lazy)
+            m_root = new XMLNode(xmlDocGetRootElement(doc));
+        else
+            m_root = readnode(xmlDocGetRootElement(doc));
+    }
+    else
+    {
+        m_root = readnode(xmlDocGetRootElement(doc));
+        xmlFreeDoc(doc);
+    }
+    return true;
+}
+
+/**
+ *  True for the characters that feed() does not pass to libxml2 as the last
+ *  character of a chunk.
+ */
+
+static inline bool
+held_back (char c)
+{
+    return c == '<' || c == '\r';
+}
+
+/**
+ *  Starts an incremental read.  The document is then passed to feed() in
+ *  chunks of any size, as they arrive, and finish() completes the tree.
+ *
+ *  This uses the libxml2 push parser.  As each child of the root element
+ *  is closed, it is converted to an XMLNode and, unless the xmlDoc is to
+ *  be kept, its libxml2 subtree is freed.  So conversion overlaps the
+ *  input, and only the open part of the document is held twice.
+ *
+ * \param to_tree_doc
+ *      If true, finish() keeps the xmlDoc for use by find().
+ *
+ * \return
+ *      Returns false if the parser could not be created.
+ */
+
+bool
+XMLTree::begin (bool to_tree_doc)
+{
+    push_reset();
+    m_filename.clear();
+    clear_root();
+    if (not_nullptr(m_doc))
+    {
+        xmlFreeDoc(m_doc);
+        m_doc = nullptr;
+    }
+    m_push = xmlCreatePushParserCtxt(NULL, NULL, NULL, 0, NULL);
+    if (is_nullptr(m_push))
+        return false;
+
+    (void) xmlCtxtUseOptions(m_push, XML_PARSE_NOBLANKS | XML_PARSE_HUGE);
+    m_push->_private = this;
+    m_push->sax->endElementNs = push_end_element;
+    m_push_keep_doc = to_tree_doc;
+    return true;
+}
+
+/**
+ *  Parses the next chunk of the document.
+ *
+ * \return
+ *      Returns false if begin() was not called or the document is not
+ *      well-formed so far.  finish() must still be called.
+ */
+
+bool
+XMLTree::feed (const char * chunk, std::size_t len)
+{
+    if (is_nullptr(m_push))
+        return false;
+
+    XMLArena::scope use_arena { m_arena.get() };
+    XMLEdits::scope reading { &m_edits };
+    if (! m_push_held.empty())
+    {
+        while (len > 0 && held_back(m_push_held.back()))
+        {
+            m_push_held += *chunk++;
+            --len;
+        }
+        if (held_back(m_push_held.back()))
+            return m_push->wellFormed != 0;
+
+        (void) xmlParseChunk
+        (
+            m_push, m_push_held.data(), int(m_push_held.size()), 0
+        );
+        m_push_held.clear();
+    }
+
+    std::size_t keep { 0 };
+    while (keep < len && held_back(chunk[len - keep - 1]))
+        ++keep;
+
+    m_push_held.assign(chunk + len - keep, keep);
+    len -= keep;
+    while (len > 0 && m_push->wellFormed)
+    {
+        int count { len > std::size_t(INT_MAX) ? INT_MAX : int(len) };
+        (void) xmlParseChunk(m_push, chunk, count, 0);
+        chunk += count;
+        len -= std::size_t(count);
+    }
+    return m_push->wellFormed != 0;
+}
+
+/**
+ *  Ends the incremental read, converting whatever is left of the document.
+ *
+ * \return
+ *      Returns true if the whole document was well-formed.  Otherwise the
+ *      partial tree is discarded.
+ */
+
+bool
+XMLTree::finish ()
+{
+    if (is_nullptr(m_push))
+        return false;
+
+    XMLArena::scope use_arena { m_arena.get() };
+    XMLEdits::scope reading { &m_edits };
+    (void) xmlParseChunk
+    (
+        m_push, m_push_held.data(), int(m_push_held.size()), 1
+    );
+    m_push_held.clear();
+
+    xmlDocPtr doc { m_push->myDoc };
+    xmlNodePtr root
+    {
+        not_nullptr(doc) ? xmlDocGetRootElement(doc) : nullptr
+    };
+    bool result { m_push->wellFormed != 0 && not_nullptr(root) };
+    if (result)
+    {
+        push_convert(root, nullptr);
+        if (m_push_keep_doc)
+        {
+            m_doc = doc;
+            m_doc_edits = m_edits.count();
+            m_push->myDoc = nullptr;
+        }
+    }
+    else
+        clear_root();
+
+    push_reset();
+    return result;
+}
+
+/**
+ *  Converts the children of the root element that follow m_push_last, up
+ *  to and including the given node (or to the end, if it is null).  The
+ *  root XMLNode itself is created on the first call.
+ */
+
+void
+XMLTree::push_convert (xmlNodePtr root, xmlNodePtr upto)
+{
+    if (is_nullptr(m_root))
+        m_root = readelement(root);
+
+    xmlNodePtr child
+    {
+        not_nullptr(m_push_last) ? m_push_last->next : root->children
+    };
+    while (not_nullptr(child))
+    {
+        m_root->add_child_nocopy(*readnode(child));
+        m_push_last = child;
+        if (child == upto)
+            break;
+
+        child = child->next;
+    }
+}
+
+/**
+ *  Frees the push parser and any document it still holds.
+ */
+
+void
+XMLTree::push_reset ()
+{
+    if (not_nullptr(m_push))
+    {
+        if (not_nullptr(m_push->myDoc))
+            xmlFreeDoc(m_push->myDoc);
+
+        xmlFreeParserCtxt(m_push);
+        m_push = nullptr;
+    }
+    m_push_last = nullptr;
+    m_push_held.clear();
+}
+
+/**
+ *  The push parser's end-of-element handler.  After libxml2 has closed the
+ *  element, a child of the root element is complete and can be converted.
+ *  libxml2's blank-node heuristic looks only at the children of the open
+ *  element, so freeing the converted subtree does not change the result.
+ */
+
+void
+XMLTree::push_end_element
+(
+    void * ctx, const xmlChar * localname,
+    const xmlChar * prefix, const xmlChar * uri
+)
+{
+    xmlParserCtxtPtr ctxt { static_cast<xmlParserCtxtPtr>(ctx) };
+    xmlNodePtr node { ctxt->node };
+    xmlSAX2EndElementNs(ctx, localname, prefix, uri);
+    if (is_nullptr(node) || is_nullptr(node->parent) || ! ctxt->wellFormed)
+        return;
+
+    xmlNodePtr root { node->parent };
+    bool top_level
+    {
+        root->type == XML_ELEMENT_NODE &&
+        root->parent == reinterpret_cast<xmlNodePtr>(ctxt->myDoc)
+    };
+    if (top_level)
+    {
+        XMLTree * tree { static_cast<XMLTree *>(ctxt->_private) };
+        tree->push_convert(root, node);
+        if (! tree->m_push_keep_doc && not_nullptr(node->children))
+        {
+            xmlFreeNodeList(node->children);
+            node->children = node->last = nullptr;
+        }
+    }
+}
+
+bool
+XMLTree::write () const
+{
+    // XMLNodeList children;
+
+    xmlKeepBlanksDefault(0);
+
+    xmlDocPtr doc { xmlNewDoc(xml_version) };
+    xmlSetDocCompressMode(doc, m_compression);
+    writenode(doc, m_root, doc->children, 1);
+
+    int result { xmlSaveFormatFileEnc(CSTR(m_filename), doc, "UTF-8", 1) };
+
+#if defined PLATFORM_DEBUG
+
+    if (result == (-1))
+    {
+        const xmlError * xerr = xmlGetLastError ();
+        if (is_nullptr(xerr))
+        {
+            std::cerr
+                << "unknown XML error during xmlSaveFormatFileEnc()."
+                << std::endl
+                ;
+        }
+        else
+        {
+            std::cerr << "xmlSaveFormatFileEnc: error"
+                << " domain: " << xerr->domain
+                << " code: " << xerr->code
+                << " msg: " << xerr->message
+                << std::endl
+                ;
+        }
+    }
+
+#endif
+
+    xmlFreeDoc(doc);
+    if (result == (-1))
+        return false;
+
+    return true;
+}
+
+void
+XMLTree::debug (FILE * out) const
+{
+#if defined XML66_DEBUG_ENABLED
+
+    // XMLNodeList children;
+
+    xmlKeepBlanksDefault(0);
+
+    xmlDocPtr doc = xmlNewDoc(xml_version);
+    xmlSetDocCompressMode(doc, m_compression);
+    writenode(doc, m_root, doc->children, 1);
+    xmlDebugDumpDocument(out, doc);
+    xmlFreeDoc(doc);
+#else
+    (void) out;
+#endif
+}
+
+const std::string &
+XMLTree::write_buffer() const
+{
+    // XMLNodeList children;
+
+    static std::string result;
+    char * ptr;
+    int len;
+
+    xmlKeepBlanksDefault(0);
+
+    xmlDocPtr doc = xmlNewDoc(xml_version);
+    xmlSetDocCompressMode(doc, m_compression);
+    writenode(doc, m_root, doc->children, 1);
+    xmlDocDumpMemory(doc, (xmlChar **) &ptr, &len);
+    xmlFreeDoc(doc);
+    result = ptr;
+    free(ptr);
+    return result;
+}
+
+/**
+ *  Makes a compact, read-only copy of the tree for queries.  The tree is
+ *  unchanged, except that lazy nodes are converted.
+ *
+ * \return
+ *      Returns an empty XMLFrozenTree if there is no root.
+ */
+
+XMLFrozenTree
+XMLTree::freeze () const
+{
+    return is_nullptr(m_root) ? XMLFrozenTree() : XMLFrozenTree(*m_root);
+}
+
+/**
+ * Class: XMLNode
+ */
+
+std::atomic<std::uint64_t> XMLNode::s_rename_epoch { 0 };
+
+XMLNode::XMLNode (const std::string & n) :
+    m_name(n)
+{
+    // No code
+}
+
+XMLNode::XMLNode (XMLName n) :
+    m_name(n)
+{
+    // No code
+}
+
+XMLNode::XMLNode (const std::string & n, const std::string & c) :
+    m_name          (n),
+    m_is_content    (true),
+    m_content       (c)
+{
+    // No code
+}
+
+/**
+ *  Creates a node for XMLTree::ingest::lazy.  Only the name and content are
+ *  converted here; see load_properties() and load_children().
+ */
+
+XMLNode::XMLNode (xmlNodePtr source) :
+    m_name
+    (
+        not_nullptr(source->name) ? (const char *) source->name : ""
+    ),
+    m_source            (source),
+    m_lazy_properties   (not_nullptr(source->properties)),
+    m_lazy_children     (not_nullptr(source->children))
+{
+    XMLEdits::quiet loading;
+    if (not_nullptr(source->content))
+        set_content((const char *) source->content);
+}
+
+XMLNode::XMLNode (const XMLNode & from) :
+    m_name(from.m_name)                 /* not a rename, see rename()       */
+{
+    XMLEdits::quiet copying;            /* a new node is not an edit        */
+    *this = from;
+}
+
+/**
+ *  Takes over the name, content, properties, and children of another node,
+ *  which is left empty.  Pointers to its children stay valid.  Not
+ *  noexcept:  the move of the properties can allocate (see XMLPropertyList),
+ *  and reporting the change to a tracked tree can too.
+ */
+
+XMLNode::XMLNode (XMLNode && from) :
+    m_name(from.m_name)                 /* not a rename, see rename()       */
+{
+    *this = std::move(from);
+}
+
+XMLNode &
+XMLNode::operator = (const XMLNode & from)
+{
+    if (this != &from)
+    {
+        {
+            XMLEdits::quiet copying;    /* reported once, below             */
+            clear_lists ();
+            rename(from.m_name);
+            set_content(from.content());
+
+            const XMLPropertyList & props { from.properties () };
+            for (auto propiter : props)
+                add_property_nocheck(propiter->atom(), propiter->value());
+
+            const XMLNodeList & nodes { from.children () };
+            for (auto childiter : nodes)
+                add_child_copy(*childiter);
+        }
+        if (XMLEdits::tracked(m_edits))
+            m_edits->replaced(*this);
+    }
+    return *this;
+}
+
+XMLNode &
+XMLNode::operator = (XMLNode && from)
+{
+    if (this != &from)
+    {
+        clear_lists();
+        rename(from.m_name);
+        m_is_content = from.m_is_content;
+        m_content = std::move(from.m_content);
+        m_children = std::move(from.m_children);
+        m_proplist = std::move(from.m_proplist);
+        m_source = from.m_source;
+        m_lazy_properties = from.m_lazy_properties;
+        m_lazy_children = from.m_lazy_children;
+        from.rename(XMLName());
+        from.m_is_content = false;
+        from.m_content.clear();
+        from.m_children.clear();
+        from.drop_child_index();
+        from.m_source = nullptr;
+        from.m_lazy_properties = from.m_lazy_children = false;
+        for (auto prop : m_proplist)
+            prop->m_owner = this;
+
+        for (auto child : m_children)
+        {
+            if (child->m_edits != m_edits)
+                child->join(m_edits);
+        }
+        if (XMLEdits::tracked(from.m_edits))
+            from.m_edits->replaced(from);
+
+        if (XMLEdits::tracked(m_edits))
+            m_edits->replaced(*this);
+    }
+    return *this;
+}
+
+/**
+ *  Changes the name of the node.  The parent, if any, may have the node in
+ *  its child index under the old name, so this bumps s_rename_epoch, which
+ *  makes each index check its names on the next lookup.
+ */
+
+void
+XMLNode::rename (XMLName name)
+{
+    if (name != m_name)
+    {
+        m_name = name;
+        s_rename_epoch.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+XMLNode::~XMLNode ()
+{
+    clear_lists();
+    if (m_in_arena)
+        XMLArena::destroyed(this);
+}
+
+/**
+ *  True if destroying the node would free heap memory:  a child list, a
+ *  child index, content too long for its string, or properties that do
+ *  (see XMLPropertyList::holds_heap()).
+ */
+
+bool
+XMLNode::holds_heap () const
+{
+    return m_children.capacity() > 0 ||
+        not_nullptr(m_child_index.load(std::memory_order_acquire)) ||
+        ! local_string(m_content) || m_proplist.holds_heap();
+}
+
+/**
+ *  Converts the properties of a lazy node.  The node object itself is
+ *  never const, so casting away the constness of these caches is safe.
+ */
+
+void
+XMLNode::load_properties () const
+{
+    XMLEdits::quiet loading;            /* only the view of the source      */
+    XMLNode * self { const_cast<XMLNode *>(this) };
+    m_lazy_properties = false;
+
+    std::string content;
+    bool check { false };               /* see add_property_nocheck()       */
+    for (xmlAttrPtr attr = m_source->properties; attr; attr = attr->next)
+    {
+        content.clear();
+        if (attr->children)
+            content = (char *) attr->children->content;
+
+        if (not_nullptr(attr->ns))
+            check = true;
+
+        if (check)
+            self->set_property((const char *)(attr->name), content);
+        else
+            self->add_property_nocheck((const char *)(attr->name), content);
+    }
+    if (! m_lazy_children)
+        m_source = nullptr;
+}
+
+/**
+ *  Converts the immediate children of a lazy node, each of which is itself
+ *  a lazy node.
+ */
+
+void
+XMLNode::load_children () const
+{
+    XMLEdits::quiet loading;
+    XMLNode * self { const_cast<XMLNode *>(this) };
+    m_lazy_children = false;
+    for (xmlNodePtr child = m_source->children; child; child = child->next)
+    {
+        XMLNode * tmp { new XMLNode(child) };
+        tmp->m_edits = m_edits;
+        self->m_children.push_back(tmp);
+    }
+
+    if (! m_lazy_properties)
+        m_source = nullptr;
+}
+
+/**
+ *  Converts all lazy properties and children of this node and all of its
+ *  descendants, after which the node no longer refers to the xmlDoc.
+ */
+
+void
+XMLNode::materialize () const
+{
+    need_properties();
+    need_children();
+    for (auto cur : m_children)
+        cur->materialize();
+}
+
+void
+XMLNode::clear_lists ()
+{
+    m_source = nullptr;                 /* lazy items are simply dropped    */
+    m_lazy_properties = m_lazy_children = false;
+    for (auto curchild : m_children)
+        delete curchild;
+
+    m_children.clear ();
+    drop_child_index();
+    m_proplist.clear();
+}
+
+bool
+XMLNode::operator == (const XMLNode & other) const
+{
+    need_properties();
+    need_children();
+    if (is_content() != other.is_content())
+        return false;
+
+    if (is_content())
+    {
+        if (content () != other.content ())
+            return false;
+    }
+    else
+    {
+        if (m_name != other.m_name)
+            return false;
+    }
+
+    XMLPropertyList const & other_properties { other.properties() };
+    if (m_proplist.size() != other_properties.size())
+        return false;
+
+    XMLPropertyConstIterator our_prop_iter { m_proplist.begin() };
+    XMLPropertyConstIterator other_prop_iter { other_properties.begin() };
+    while (our_prop_iter != m_proplist.end ())
+    {
+        XMLProperty const * our_prop = *our_prop_iter;
+        XMLProperty const * other_prop = *other_prop_iter;
+        if
+        (
+            our_prop->atom() != other_prop->atom() ||
+            our_prop->value() != other_prop->value()
+        )
+        {
+            return false;
+        }
+        ++our_prop_iter;
+        ++other_prop_iter;
+    }
+
+    XMLNodeList const & other_children { other.children() };
+    if (m_children.size() != other_children.size())
+        return false;
+
+    XMLNodeConstIterator our_child_iter { m_children.begin() };
+    XMLNodeConstIterator other_child_iter { other_children.begin() };
+    while (our_child_iter != m_children.end())
+    {
+        XMLNode const * our_child { *our_child_iter };
+        XMLNode const * other_child { *other_child_iter };
+        if (*our_child != *other_child)
+            return false;
+
+        ++our_child_iter;
+        ++other_child_iter;
+    }
+    return true;
+}
+
+bool
+XMLNode::operator != (const XMLNode & other) const
+{
+    return ! (*this == other);
+}
+
+const std::string &
+XMLNode::set_content (const std::string & c)
+{
+    m_is_content = ! c.empty();
+    m_content = c;
+    if (XMLEdits::tracked(m_edits))
+        m_edits->content(*this);
+
+    return m_content;
+}
+
+/**
+ *  Return the content of the first content child
+ *
+ *  '<node>Foo</node>'.
+ *
+ *  the 'node' is not a content node, but has a child-node 'text'.
+ *
+ * This method effectively is identical to
+ *
+ *      return this->child("text")->content()
+ */
+
+const std::string &
+XMLNode::child_content () const
+{
+    static const std::string s_empty;
+    for (auto n : children())
+    {
+        if (n->is_content())
+            return n->content();
+    }
+    return s_empty;
+}
+
+/**
+ *  Returns first child matching name.
+ */
+
+XMLNode *
+XMLNode::child (const char * name) const
+{
+    need_children();
+    XMLName atom;
+    if (not_nullptr(name) && XMLName::find(name, atom))
+    {
+        const XMLNodeList * named
+        {
+            indexed_children(atom, m_children.size() >= c_child_index_threshold)
+        };
+        if (not_nullptr(named))
+            return named->empty() ? nullptr : named->front();
+
+        for (auto cur : m_children)
+        {
+            if (cur->m_name == atom)
+                return cur;
+        }
+    }
+    return 0;
+}
+
+/**
+ *  Returns a copy of the children matching name, or of all children if the
+ *  name is empty.  A node with at least c_child_index_threshold children
+ *  copies the list from its child index, building the index if needed;
+ *  smaller nodes are scanned, so they never allocate an index.  Safe to
+ *  call from several threads at once on an unchanging tree.  See
+ *  children_named() for a view that does not copy.
+ */
+
+XMLNodeList
+XMLNode::children (const std::string & n) const
+{
+    need_children();
+    if (n.empty())
+        return m_children;
+
+    XMLNodeList result;
+    XMLName atom;
+    if (XMLName::find(n, atom))
+    {
+        const XMLNodeList * named
+        {
+            indexed_children(atom, m_children.size() >= c_child_index_threshold)
+        };
+        if (not_nullptr(named))
+            return *named;
+
+        for (auto cur : m_children)
+        {
+            if (cur->m_name == atom)
+                result.push_back(cur);
+        }
+    }
+    return result;
+}
+
+/**
+ *  Iterates over the children with the given name, without building the
+ *  child index, copying, or changing the node.
+ */
+
+XMLChildRange<XMLNode::name_match>
+XMLNode::children_named (std::string_view name) const
+{
+    need_children();
+    XMLName atom;
+    XMLNodeConstIterator last { m_children.end() };
+    XMLNodeConstIterator first
+    {
+        XMLName::find(name, atom) ? m_children.begin() : last
+    };
+    return XMLChildRange<name_match>(first, last, name_match(atom));
+}
+
+/**
+ *  Looks up the children with a given name in the child index.
+ *
+ * \param atom
+ *      The name to look up.
+ *
+ * \param build
+ *      If true, and there is no index yet, one is built and published.
+ *
+ * \return
+ *      Returns null if there is no index and none was built.  Otherwise
+ *      returns the list of children with that name, which may be empty.
+ */
+
+const XMLNodeList *
+XMLNode::indexed_children (XMLName atom, bool build) const
+{
+    static const XMLNodeList s_none;
+    std::uint64_t epoch { s_rename_epoch.load(std::memory_order_relaxed) };
+    child_index * index { m_child_index.load(std::memory_order_acquire) };
+    if (is_nullptr(index))
+    {
+        if (! build)
+            return nullptr;
+
+        index = publish_child_index(nullptr, epoch);
+    }
+    else if (index->epoch.load(std::memory_order_relaxed) != epoch)
+    {
+        if (index_matches(*index))
+            index->epoch.store(epoch, std::memory_order_relaxed);
+        else
+            index = publish_child_index(index, epoch);
+    }
+
+    auto it { index->lists.find(atom) };
+    return it != index->lists.end() ? &it->second : &s_none;
+}
+
+/**
+ *  Checks that no child has been renamed since the index was built.
+ */
+
+bool
+XMLNode::index_matches (const child_index & index) const
+{
+    if (index.names.size() != m_children.size())
+        return false;
+
+    for (std::size_t i = 0; i < m_children.size(); ++i)
+    {
+        if (m_children[i]->m_name != index.names[i])
+            return false;
+    }
+    return true;
+}
+
+/**
+ *  Builds a child index and publishes it with a compare-and-swap.
+ *
+ * \param stale
+ *      The index being replaced, or null if there is none.  Other threads
+ *      may still be reading it, so it is retired rather than deleted.
+ *
+ * \param epoch
+ *      The value of s_rename_epoch the index is current for.
+ *
+ * 
+eturn
+ *      Returns the published index, which is another thread's if that
+ *      thread published one first.
+ */
+
+XMLNode::child_index *
+XMLNode::publish_child_index (child_index * stale, std::uint64_t epoch) const
+{
+    std::unique_ptr<child_index> fresh { std::make_unique<child_index>() };
+    fresh->names.reserve(m_children.size());
+    for (auto cur : m_children)
+    {
+        fresh->lists[cur->m_name].push_back(cur);
+        fresh->names.push_back(cur->m_name);
+    }
+    fresh->epoch.store(epoch, std::memory_order_relaxed);
+    fresh->retired.reset(stale);
+
+    child_index * expected { stale };
+    bool published
+    {
+        m_child_index.compare_exchange_strong
+        (
+            expected, fresh.get(),
+            std::memory_order_acq_rel, std::memory_order_acquire
+        )
+    };
+    if (published)
+        return fresh.release();
+
+    (void) fresh->retired.release();    /* the winner's index retired it    */
+    return expected;
+}
+
+XMLNode *
+XMLNode::add_child (const char * n)
+{
+    return emplace_child(XMLName(n));
+}
+
+/**
+ *  Adopts the contents of a node without copying its subtree.
+ */
+
+XMLNode *
+XMLNode::add_child (XMLNode && n)
+{
+    return emplace_child(std::move(n));
+}
+
+void
+XMLNode::add_child_nocopy (XMLNode & n)
+{
+    need_children();
+    m_children.push_back(&n);
+    index_child(&n);
+    adopt(n);
+}
+
+XMLNode *
+XMLNode::add_child_copy (const XMLNode & n)
+{
+    need_children();
+    XMLNode * copy { new XMLNode(n) };
+    m_children.push_back(copy);
+    index_child(copy);
+    adopt(*copy);
+    return copy;
+}
+
+/**
+ *  Makes this node and its descendants part of the tree with the given
+ *  edits, or of none.  Lazy children not yet converted take the edits of
+ *  their parent when they are.
+ */
+
+void
+XMLNode::join (XMLEdits * edits)
+{
+    std::vector<XMLNode *> pending { this };
+    while (! pending.empty())
+    {
+        XMLNode * node { pending.back() };
+        pending.pop_back();
+        node->m_edits = edits;
+        for (auto child : node->m_children)
+            pending.push_back(child);
+    }
+}
+
+/**
+ *  Makes a child just appended part of this node's tree, and reports it.
+ */
+
+void
+XMLNode::adopt (XMLNode & child)
+{
+    if (child.m_edits != m_edits)
+        child.join(m_edits);
+
+    if (XMLEdits::tracked(m_edits))
+        m_edits->added(*this, child);
+}
+
+/**
+ *  Reports a child about to be removed from this node.
+ */
+
+void
+XMLNode::disown (XMLNode & child)
+{
+    if (XMLEdits::tracked(m_edits))
+        m_edits->removing(*this, child);
+}
+
+/**
+ *  The root node written into an xmlDoc for libxml2, with the maps between
+ *  the two.  It is kept, and shared by concurrent queries, until the tree
+ *  is read again; as the nodes change, it is patched (see patchable_doc()).
+ *  Each function that patches it returns false if it does not hold the
+ *  node changed, in which case it is simply dropped.
+ */
+
+struct XMLTree::query_doc
+{
+    xmlDocPtr doc { nullptr };
+    node_map refs { };
+    std::unordered_map<const XMLNode *, xmlNodePtr> nodes { };
+
+    ~query_doc ()
+    {
+        if (not_nullptr(doc))
+            xmlFreeDoc(doc);
+    }
+
+    xmlNodePtr lookup (const XMLNode & node) const
+    {
+        auto it { nodes.find(&node) };
+        return it != nodes.end() ? it->second : nullptr;
+    }
+
+    void map (xmlNodePtr x);
+    void unmap (xmlNodePtr x);
+    bool write_properties (XMLNode & node);
+    bool append (XMLNode & parent, XMLNode & child);
+    bool remove (const XMLNode & child);
+    bool rewrite (XMLNode & node);
+};
+
+/**
+ *  Records the libxml2 nodes just written for an XMLNode subtree, from the
+ *  entries writenode() made in refs.
+ */
+
+void
+XMLTree::query_doc::map (xmlNodePtr x)
+{
+    auto it { refs.find(x) };
+    if (it != refs.end())
+        nodes[it->second.node] = x;
+
+    for (xmlNodePtr c = x->children; not_nullptr(c); c = c->next)
+        map(c);
+}
+
+/**
+ *  Forgets a libxml2 subtree about to be freed.  Its XMLNodes may already
+ *  be gone, so they are only used as keys, and an XMLNode now mapped to
+ *  another libxml2 node is left alone.
+ */
+
+void
+XMLTree::query_doc::unmap (xmlNodePtr x)
+{
+    auto it { refs.find(x) };
+    if (it != refs.end())
+    {
+        auto n { nodes.find(it->second.node) };
+        if (n != nodes.end() && n->second == x)
+            nodes.erase(n);
+
+        refs.erase(it);
+    }
+    if (x->type == XML_ELEMENT_NODE)
+    {
+        for (xmlAttrPtr a = x->properties; not_nullptr(a); a = a->next)
+            refs.erase(a);
+    }
+    for (xmlNodePtr c = x->children; not_nullptr(c); c = c->next)
+        unmap(c);
+}
+
+bool
+XMLTree::query_doc::write_properties (XMLNode & node)
+{
+    xmlNodePtr x { lookup(node) };
+    if (is_nullptr(x) || x->type != XML_ELEMENT_NODE)
+        return false;
+
+    for (xmlAttrPtr a = x->properties; not_nullptr(a); a = a->next)
+        refs.erase(a);
+
+    xmlFreePropList(x->properties);
+    x->properties = nullptr;
+    for (auto prop : node.properties())
+    {
+        xmlAttrPtr attr
+        {
+            xmlSetProp
+            (
+                x, (const xmlChar *) CSTR(prop->name()),
+                (const xmlChar *) CSTR(prop->value())
+            )
+        };
+        refs[attr] = XMLNodeRef{ &node, prop };
+    }
+    return true;
+}
+
+bool
+XMLTree::query_doc::append (XMLNode & parent, XMLNode & child)
+{
+    xmlNodePtr x { lookup(parent) };
+    if (is_nullptr(x))
+        return false;
+
+    writenode(doc, &child, x, 0, &refs);
+    map(x->last);
+    return true;
+}
+
+bool
+XMLTree::query_doc::remove (const XMLNode & child)
+{
+    xmlNodePtr x { lookup(child) };
+    if (is_nullptr(x))
+        return false;
+
+    unmap(x);
+    xmlUnlinkNode(x);
+    xmlFreeNode(x);
+    return true;
+}
+
+/**
+ *  Writes a node again, in place.  The root element is not rewritten; the
+ *  whole xmlDoc is dropped instead.
+ */
+
+bool
+XMLTree::query_doc::rewrite (XMLNode & node)
+{
+    xmlNodePtr x { lookup(node) };
+    if (is_nullptr(x) || x == xmlDocGetRootElement(doc))
+        return false;
+
+    xmlNodePtr parent { x->parent };
+    unmap(x);
+    writenode(doc, &node, parent, 0, &refs);
+    xmlNodePtr fresh { parent->last };
+    xmlUnlinkNode(fresh);
+    (void) xmlReplaceNode(x, fresh);
+    xmlFreeNode(x);
+    map(fresh);
+    return true;
+}
+
+std::shared_ptr<const XMLTree::query_doc>
+XMLTree::root_doc () const
+{
+    std::lock_guard<std::mutex> lock { m_query_doc_mutex };
+    if (! m_query_doc)
+    {
+        std::shared_ptr<query_doc> qd { std::make_shared<query_doc>() };
+        qd->doc = xmlNewDoc(xml_version);
+        writenode(qd->doc, m_root, qd->doc->children, 1, &qd->refs);
+        qd->map(xmlDocGetRootElement(qd->doc));
+        m_query_doc = qd;
+    }
+    return m_query_doc;
+}
+
+/**
+ *  Forgets the xmlDoc of root_doc() and the built indexes, which refer to
+ *  nodes that are about to go away.  The index keys are kept, so the
+ *  indexes are built again for the next root.
+ */
+
+void
+XMLTree::drop_caches ()
+{
+    {
+        std::lock_guard<std::mutex> lock { m_query_doc_mutex };
+        m_query_doc.reset();
+    }
+    std::lock_guard<std::mutex> lock { m_index_mutex };
+    m_indexes.reset();
+}
+
+/**
+ *  The xmlDoc of root_doc(), if one is kept and no query is using it, to
+ *  be patched for a change to the nodes.  One in use is dropped, and
+ *  written again for the next query.  The caller holds m_query_doc_mutex.
+ */
+
+XMLTree::query_doc *
+XMLTree::patchable_doc ()
+{
+    if (m_query_doc && m_query_doc.use_count() > 1)
+        m_query_doc.reset();
+
+    return m_query_doc.get();
+}
+
+/**
+ *  The indexes of m_root, to be patched for a change to the nodes, or null
+ *  if none are built.  A list or index still in use by a query is copied
+ *  first.  The caller holds m_index_mutex.
+ */
+
+XMLIndexList *
+XMLTree::patchable_indexes () const
+{
+    if (! m_indexes)
+        return nullptr;
+
+    if (m_indexes.use_count() > 1)
+        m_indexes = std::make_shared<XMLIndexList>(*m_indexes);
+
+    for (auto & x : *m_indexes)
+    {
+        if (x.use_count() > 1)
+            x = std::make_shared<XMLIndex>(*x);
+    }
+    return m_indexes.get();
+}
+
+/*
+ * The changes to the nodes, reported by m_edits.  Each patches the xmlDoc
+ * of root_doc() and the indexes.
+ */
+
+void
+XMLTree::property_edited
+(
+    XMLNode & node, XMLName name,
+    const std::string * before, const std::string * after
+)
+{
+    {
+        std::lock_guard<std::mutex> lock { m_query_doc_mutex };
+        query_doc * qd { patchable_doc() };
+        if (not_nullptr(qd) && ! qd->write_properties(node))
+            m_query_doc.reset();
+    }
+    std::lock_guard<std::mutex> lock { m_index_mutex };
+    XMLIndexList * built { patchable_indexes() };
+    if (not_nullptr(built))
+    {
+        for (auto & x : *built)
+        {
+            if (x->element() == node.atom() && x->attribute() == name)
+                x->update(node, before, after);
+        }
+    }
+}
+
+/**
+ *  A node that changes between element and content would gain or lose
+ *  its entries, so indexes of its name are built again.
+ */
+
+void
+XMLTree::content_edited (XMLNode & node)
+{
+    {
+        std::lock_guard<std::mutex> lock { m_query_doc_mutex };
+        query_doc * qd { patchable_doc() };
+        if (not_nullptr(qd) && ! qd->rewrite(node))
+            m_query_doc.reset();
+    }
+    std::lock_guard<std::mutex> lock { m_index_mutex };
+    XMLIndexList * built { patchable_indexes() };
+    if (not_nullptr(built))
+    {
+        for (auto & x : *built)
+        {
+            if (x->element() == node.atom())
+                x->invalidate();
+        }
+    }
+}
+
+void
+XMLTree::child_added (XMLNode & parent, XMLNode & child)
+{
+    {
+        std::lock_guard<std::mutex> lock { m_query_doc_mutex };
+        query_doc * qd { patchable_doc() };
+        if (not_nullptr(qd) && ! qd->append(parent, child))
+            m_query_doc.reset();
+    }
+    std::lock_guard<std::mutex> lock { m_index_mutex };
+    XMLIndexList * built { patchable_indexes() };
+    if (not_nullptr(built))
+    {
+        for (auto & x : *built)
+            x->added(child);
+    }
+}
+
+void
+XMLTree::child_removing (XMLNode & child)
+{
+    {
+        std::lock_guard<std::mutex> lock { m_query_doc_mutex };
+        query_doc * qd { patchable_doc() };
+        if (not_nullptr(qd) && ! qd->remove(child))
+            m_query_doc.reset();
+    }
+    std::lock_guard<std::mutex> lock { m_index_mutex };
+    XMLIndexList * built { patchable_indexes() };
+    if (not_nullptr(built))
+    {
+        for (auto & x : *built)
+            x->removing(child);
+    }
+}
+
+/**
+ *  The old subtree of an assigned node is gone, so its entries cannot be
+ *  found; the indexes are built again.
+ */
+
+void
+XMLTree::node_replaced (XMLNode & node)
+{
+    {
+        std::lock_guard<std::mutex> lock { m_query_doc_mutex };
+        query_doc * qd { patchable_doc() };
+        if (not_nullptr(qd) && ! qd->rewrite(node))
+            m_query_doc.reset();
+    }
+    std::lock_guard<std::mutex> lock { m_index_mutex };
+    XMLIndexList * built { patchable_indexes() };
+    if (not_nullptr(built))
+    {
+        for (auto & x : *built)
+            x->invalidate();
+    }
+}
+
+/**
+ *  Indexes the elements of the given name by the value of an attribute.
+ *  find() and find_nodes() then answer steps such as
+ *  "Source[@id='1234']", against the whole tree, with a hash lookup
+ *  instead of visiting every node, when the query is in the XMLXPath
+ *  subset.  The index is built now, and kept current as the nodes of the
+ *  tree change (see XMLIndex).  A lazy tree is fully converted.
+ *
+ * \return
+ *      Returns false if the tree is empty.  The index is still kept, for
+ *      the next read.
+ */
+
+bool
+XMLTree::build_index
+(
+    const std::string & element, const std::string & attribute
+)
+{
+    std::pair<XMLName, XMLName> key { XMLName(element), XMLName(attribute) };
+    {
+        std::lock_guard<std::mutex> lock { m_index_mutex };
+        auto it { std::find(m_index_keys.begin(), m_index_keys.end(), key) };
+        if (it == m_index_keys.end())
+            m_index_keys.push_back(key);
+
+        m_indexes.reset();
+    }
+    return bool(indexes());
+}
+
+void
+XMLTree::drop_indexes ()
+{
+    std::lock_guard<std::mutex> lock { m_index_mutex };
+    m_index_keys.clear();
+    m_indexes.reset();
+}
+
+/**
+ * \return
+ *      Returns the indexes of m_root, of which those made stale by changes
+ *      are built again, or null if there are none or no root.
+ */
+
+std::shared_ptr<const XMLIndexList>
+XMLTree::indexes () const
+{
+    std::lock_guard<std::mutex> lock { m_index_mutex };
+    if (m_index_keys.empty() || is_nullptr(m_root))
+        return std::shared_ptr<const XMLIndexList>();
+
+    if (! m_indexes)
+    {
+        std::shared_ptr<XMLIndexList> built
+        {
+            std::make_shared<XMLIndexList>()
+        };
+        built->reserve(m_index_keys.size());
+        for (const auto & k : m_index_keys)
+        {
+            std::shared_ptr<XMLIndex> x
+            {
+                std::make_shared<XMLIndex>(k.first, k.second)
+            };
+            x->build(*m_root);
+            built->push_back(x);
+        }
+        m_indexes = built;
+    }
+    else
+    {
+        bool stale { false };
+        for (const auto & x : *m_indexes)
+            stale = stale || x->stale();
 
-        const XMLNodeList & nodes { from.children () };
-        for (auto childiter : nodes)
-            add_child_copy(*childiter);
+        if (stale)
+        {
+            for (auto & x : *patchable_indexes())
+            {
+                if (x->stale())
+                    x->build(*m_root);
+            }
+        }
     }
-    return *this;
+    return m_indexes;
 }
 
-XMLNode::~XMLNode ()
+/**
+ *  Evaluates an XPath expression against the given node or, if null, the
+ *  whole document.  The expression is compiled once and kept in the query
+ *  cache; see XMLQueryCache.
+ */
+
+SharedNodeListPtr
+XMLTree::find (const std::string xpath, XMLNode * node) const
 {
-    clear_lists();
+    return find(*query(xpath), node);
 }
 
-void
-XMLNode::clear_lists ()
+/**
+ *  Evaluates a compiled query against the given node or, if null, the
+ *  whole document.  The kept xmlDoc is used only while it matches the
+ *  nodes (see doc_current()).  If the tree was read without keeping one
+ *  (see XMLTree::ingest), or its nodes have changed since, the root node
+ *  is used.
+ *
+ *  A query against a node is evaluated on the XMLNode tree by XMLXPath,
+ *  when it is in the supported subset.  Otherwise the node is written into
+ *  an xmlDoc for libxml2; for the root node, that xmlDoc is kept, and
+ *  patched as the nodes change.  Either way, the results are copies of the
+ *  selected nodes.
+ *
+ *  A simple path, or a query of the whole tree that can use an index from
+ *  build_index(), is always evaluated by XMLXPath, on the root node.  See
+ *  explain().
+ */
+
+SharedNodeListPtr
+XMLTree::find (const XMLQuery & query, XMLNode * node) const
 {
-    m_selected_children.clear();
-    for (auto curchild : m_children)
-        delete curchild;
+    std::shared_ptr<const XMLIndexList> built;
+    if (not_nullptr(query.native()) && (is_nullptr(node) || node == m_root))
+        built = indexes();
 
-    m_children.clear ();
-    for (auto curprop : m_proplist)
-        delete curprop;
+    plan p { choose(query, node, built.get()) };
+    if (p == plan::none)
+        return SharedNodeListPtr(new XMLSharedNodeList());
 
-    m_proplist.clear();
-}
+    if (is_nullptr(node) && p != plan::document)
+        node = m_root;
 
-bool
-XMLNode::operator == (const XMLNode & other) const
-{
-    if (is_content() != other.is_content())
-        return false;
+    if (p == plan::walk || p == plan::index || p == plan::native)
+        return find_native(*query.native(), *node, built.get());
 
-    if (is_content())
+    std::shared_ptr<const query_doc> shared;
+    xmlDocPtr doc { m_doc };
+    xmlDocPtr temp { nullptr };
+    if (not_nullptr(node) && node == m_root)
     {
-        if (content () != other.content ())
-            return false;
+        shared = root_doc();
+        doc = shared->doc;
     }
-    else
+    else if (not_nullptr(node))
     {
-        if (name() != other.name())
-            return false;
+        doc = temp = xmlNewDoc(xml_version);
+        writenode(temp, node, temp->children, 1);
     }
 
-    XMLPropertyList const & other_properties { other.properties() };
-    if (m_proplist.size() != other_properties.size())
-        return false;
-
-    XMLPropertyConstIterator our_prop_iter { m_proplist.begin() };
-    XMLPropertyConstIterator other_prop_iter { other_properties.begin() };
-    while (our_prop_iter != m_proplist.end ())
+    xmlXPathContext * ctxt { xmlXPathNewContext(doc) };
+    SharedNodeListPtr result;
+    try
     {
-        XMLProperty const * our_prop = *our_prop_iter;
-        XMLProperty const * other_prop = *other_prop_iter;
-        if
-        (
-            our_prop->name() != other_prop->name() ||
-            our_prop->value() != other_prop->value()
-        )
-        {
-            return false;
-        }
-        ++our_prop_iter;
-        ++other_prop_iter;
+        result.reset(find_impl(ctxt, query));
     }
+    catch (const XMLException &)
+    {
+        xmlXPathFreeContext(ctxt);
+        if (not_nullptr(temp))
+            xmlFreeDoc(temp);
 
-    XMLNodeList const & other_children { other.children() };
-    if (m_children.size() != other_children.size())
-        return false;
+        throw;
+    }
+    xmlXPathFreeContext(ctxt);
+    if (not_nullptr(temp))
+        xmlFreeDoc(temp);
 
-    XMLNodeConstIterator our_child_iter { m_children.begin() };
-    XMLNodeConstIterator other_child_iter { other_children.begin() };
-    while (our_child_iter != m_children.end())
+    return result;
+}
+
+/**
+ *  Chooses how find() evaluates a query; see find() and XMLTree::plan.
+ *
+ * \param built
+ *      The indexes of the tree, if the query is against the whole tree.
+ */
+
+XMLTree::plan
+XMLTree::choose
+(
+    const XMLQuery & query, const XMLNode * node,
+    const XMLIndexList * built
+) const
+{
+    if (is_nullptr(node) && is_nullptr(m_root) && ! doc_current())
+        return plan::none;
+
+    const XMLXPath * native { query.native() };
+    if (not_nullptr(native))
     {
-        XMLNode const * our_child { *our_child_iter };
-        XMLNode const * other_child { *other_child_iter };
-        if (*our_child != *other_child)
-            return false;
+        if (not_nullptr(built) && native->uses_index(*built))
+            return plan::index;
 
-        ++our_child_iter;
-        ++other_child_iter;
+        if (native->simple())
+            return plan::walk;
+
+        if (not_nullptr(node) || ! doc_current())
+            return plan::native;
     }
-    return true;
+    return is_nullptr(node) && doc_current() ? plan::document : plan::libxml;
 }
 
-bool
-XMLNode::operator != (const XMLNode & other) const
+/**
+ *  Reports how find() would evaluate a query against the given node, or
+ *  the whole tree, without evaluating it.  Hot queries can be checked for
+ *  plan::walk or plan::index.  Indexes are built if needed.
+ */
+
+XMLTree::plan
+XMLTree::explain (const XMLQuery & query, XMLNode * node) const
 {
-    return ! (*this == other);
+    std::shared_ptr<const XMLIndexList> built;
+    if (not_nullptr(query.native()) && (is_nullptr(node) || node == m_root))
+        built = indexes();
+
+    return choose(query, node, built.get());
 }
 
-const std::string &
-XMLNode::set_content (const std::string & c)
+const char *
+XMLTree::plan_name (plan p)
 {
-    m_is_content = ! c.empty();
-    m_content = c;
-    return m_content;
+    switch (p)
+    {
+    case plan::walk:        return "walk";
+    case plan::index:       return "index";
+    case plan::native:      return "native";
+    case plan::document:    return "document";
+    case plan::libxml:      return "libxml";
+    case plan::none:        return "none";
+    }
+    return "?";
 }
 
 /**
- *  Return the content of the first content child
- *
- *  '<node>Foo</node>'.
- *
- *  the 'node' is not a content node, but has a child-node 'text'.
+ *  Evaluates several expressions against the given node or, if null, the
+ *  whole document, as find() does for each.  The expressions that find()
+ *  would evaluate by visiting the whole tree (plan::native or
+ *  plan::document) and that are forward paths (see XMLXPath::forward())
+ *  share one depth-first pass; the rest are evaluated by find().  For
+ *  plan::document, this relies on XMLXPath giving the same results as
+ *  libxml2, down to its conversions of numbers.
  *
- * This method effectively is identical to
+ * \throw
+ *      Throws XMLException if any expression is invalid, or fails.
  *
- *      return this->child("text")->content()
+ * \return
+ *      Returns the results of the expressions, in the same order.
  */
 
-const std::string &
-XMLNode::child_content () const
+std::vector<SharedNodeListPtr>
+XMLTree::find_many
+(
+    const std::vector<std::string> & xpaths, XMLNode * node
+) const
 {
-    static const std::string s_empty;
-    for (auto n : children())
+    std::vector<SharedNodeListPtr> result(xpaths.size());
+    std::vector<XMLQueryPtr> queries;
+    queries.reserve(xpaths.size());
+    for (const auto & xpath : xpaths)
+        queries.push_back(query(xpath));
+
+    std::shared_ptr<const XMLIndexList> built;
+    if (is_nullptr(node) || node == m_root)
+        built = indexes();
+
+    std::vector<const XMLXPath *> batch;
+    std::vector<std::size_t> slots;
+    for (std::size_t i = 0; i < queries.size(); ++i)
     {
-        if (n->is_content())
-            return n->content();
+        const XMLQuery & q { *queries[i] };
+        plan p { choose(q, node, built.get()) };
+        bool shared
+        {
+            (p == plan::native || p == plan::document) &&
+            not_nullptr(q.native()) && q.native()->forward()
+        };
+        if (shared)
+        {
+            batch.push_back(q.native());
+            slots.push_back(i);
+        }
+        else
+            result[i] = find(q, node);
     }
-    return s_empty;
+    if (! batch.empty())
+    {
+        const XMLNode & top { not_nullptr(node) ? *node : *m_root };
+        std::vector<XMLXPath::hit_list> hits
+        {
+            XMLXPath::select_many(batch, top)
+        };
+        for (std::size_t j = 0; j < slots.size(); ++j)
+            result[slots[j]] = copy_hits(hits[j], top);
+    }
+    return result;
 }
 
 /**
- *  Returns first child matching name.
+ *  Evaluates a compiled query against the given node or, if null, the root
+ *  node, and returns the selected nodes of the tree itself instead of
+ *  copies.  Changes made through the results change the tree.  The
+ *  results are valid until the nodes are removed or the tree is read
+ *  again.
+ *
+ *  A query outside the native subset is evaluated by libxml2 on a
+ *  temporary copy of the node, and its results are mapped back to the
+ *  XMLNodes.  Selected nodes that have no XMLNode, such as the document
+ *  node, are left out.
  */
 
-XMLNode *
-XMLNode::child (const char * name) const
+XMLNodeRefList
+XMLTree::find_nodes (const XMLQuery & query, XMLNode * node) const
 {
-    if (not_nullptr(name))
+    XMLNodeRefList result;
+    if (is_nullptr(node))
+        node = m_root;
+
+    if (is_nullptr(node))
+        return result;
+
+    if (not_nullptr(query.native()))
     {
-        for (auto cur : m_children)
+        std::shared_ptr<const XMLIndexList> built;
+        if (node == m_root)
+            built = indexes();
+
+        XMLXPath::hit_list hits { query.native()->select(*node, built.get()) };
+        result.reserve(hits.size());
+        for (const auto & h : hits)
         {
-            if (cur->name() == name)
-                return cur;
+            if (not_nullptr(h.node))                /* not the document     */
+            {
+                result.push_back
+                (
+                    XMLNodeRef
+                    {
+                        const_cast<XMLNode *>(h.node),
+                        const_cast<XMLProperty *>(h.property)
+                    }
+                );
+            }
         }
+        return result;
     }
-    return 0;
-}
-
-/**
- *  Returns all children matching name.
- */
 
-const XMLNodeList &
-XMLNode::children (const std::string & n) const
-{
-    if (n.empty())
+    std::shared_ptr<const query_doc> shared;
+    node_map local;
+    const node_map * refs { &local };
+    xmlDocPtr doc { nullptr };
+    xmlDocPtr temp { nullptr };
+    if (node == m_root)
     {
-        return m_children;
+        shared = root_doc();
+        doc = shared->doc;
+        refs = &shared->refs;
     }
     else
     {
-        m_selected_children.clear();
-        for (auto cur : m_children)
+        doc = temp = xmlNewDoc(xml_version);
+        writenode(temp, node, temp->children, 1, &local);
+    }
+
+    xmlXPathContext * ctxt { xmlXPathNewContext(doc) };
+    xmlXPathObject * found { nullptr };
+    try
+    {
+        found = eval_nodeset(ctxt, query);
+    }
+    catch (const XMLException &)
+    {
+        xmlXPathFreeContext(ctxt);
+        if (not_nullptr(temp))
+            xmlFreeDoc(temp);
+
+        throw;
+    }
+
+    xmlNodeSet * nodeset { found->nodesetval };
+    if (not_nullptr(nodeset))
+    {
+        result.reserve(std::size_t(nodeset->nodeNr));
+        for (int i = 0; i < nodeset->nodeNr; ++i)
         {
-            if (cur->name() == n)
-                m_selected_children.insert(m_selected_children.end(), cur);
+            auto it { refs->find(nodeset->nodeTab[i]) };
+            if (it != refs->end())
+                result.push_back(it->second);
         }
-        return m_selected_children;
     }
-}
+    xmlXPathFreeObject(found);
+    xmlXPathFreeContext(ctxt);
+    if (not_nullptr(temp))
+        xmlFreeDoc(temp);
 
-XMLNode *
-XMLNode::add_child (const char * n)
-{
-    return add_child_copy(XMLNode (n));
+    return result;
 }
 
-void
-XMLNode::add_child_nocopy (XMLNode & n)
-{
-    m_children.insert(m_children.end(), &n);
-}
+/**
+ *  Evaluates an expression with XMLXPath, and copies the nodes selected;
+ *  see copy_hits().
+ */
 
-XMLNode *
-XMLNode::add_child_copy (const XMLNode & n)
+SharedNodeListPtr
+XMLTree::find_native
+(
+    const XMLXPath & xpath, const XMLNode & node,
+    const XMLIndexList * indexes
+)
 {
-    XMLNode * copy { new XMLNode(n) };
-    m_children.insert(m_children.end(), copy);
-    return copy;
+    return copy_hits(xpath.select(node, indexes), node);
 }
 
-// std::shared_ptr<XMLSharedNodeList>
+/**
+ *  Copies the nodes selected by XMLXPath into the form that find_impl()
+ *  makes from libxml2's nodes.  An attribute becomes a node named for the
+ *  attribute, with a "text" child holding the value, and the document
+ *  becomes an unnamed node holding the root.
+ */
 
 SharedNodeListPtr
-XMLTree::find (const std::string xpath, XMLNode * node) const
+XMLTree::copy_hits (const XMLXPath::hit_list & hits, const XMLNode & node)
 {
-    xmlXPathContext * ctxt { nullptr };
-    xmlDocPtr doc { nullptr };
-    if (not_nullptr(node))
-    {
-        doc = xmlNewDoc(xml_version);
-        writenode(doc, node, doc->children, 1);
-        ctxt = xmlXPathNewContext(doc);
-    }
-    else
+    XMLEdits::quiet copying;            /* copies are new nodes, not edits  */
+    SharedNodeListPtr result { std::make_shared<XMLSharedNodeList>() };
+    result->reserve(hits.size());
+    for (const auto & h : hits)
     {
-        ctxt = xmlXPathNewContext(m_doc);
+        XMLNode * copy { nullptr };
+        if (not_nullptr(h.property))
+        {
+            copy = new XMLNode(h.property->atom());
+            XMLNode * text { copy->emplace_child(std::string("text")) };
+            (void) text->set_content(h.property->value());
+        }
+        else if (not_nullptr(h.node))
+        {
+            copy = new XMLNode(*h.node);
+        }
+        else
+        {
+            copy = new XMLNode(XMLName());
+            (void) copy->add_child_copy(node);
+        }
+        result->push_back(XMLNodePtr(copy));
     }
-
-#if 0
-    std::shared_ptr<XMLSharedNodeList> result =
-        std::shared_ptr<XMLSharedNodeList>(find_impl(ctxt, xpath));
-#endif
-
-    SharedNodeListPtr result { SharedNodeListPtr(find_impl(ctxt, xpath)) };
-    xmlXPathFreeContext(ctxt);
-    if (not_nullptr(doc))
-        xmlFreeDoc(doc);
-
     return result;
 }
 
@@ -653,19 +2882,21 @@ XMLNode::add_content (const std::string & c)
 
         return nullptr;
     }
-    return add_child_copy(XMLNode(std::string(), c));
+    return emplace_child(std::string(), c);
 }
 
 XMLProperty const *
 XMLNode::property (const char * name) const
 {
-    XMLPropertyConstIterator iter { m_proplist.begin() };
-    while (iter != m_proplist.end())
-    {
-        if ((*iter)->name() == name)
-            return *iter;
+    need_properties();
+    XMLName atom;
+    if (is_nullptr(name) || ! XMLName::find(name, atom))
+        return nullptr;
 
-        ++iter;
+    for (auto prop : m_proplist)
+    {
+        if (prop->atom() == atom)
+            return prop;
     }
     return nullptr;
 }
@@ -728,13 +2959,15 @@ XMLNode::has_property_with_value
     const std::string & value
 ) const
 {
-    XMLPropertyConstIterator iter { m_proplist.begin() };
-    while (iter != m_proplist.end())
+    need_properties();
+    XMLName atom;
+    if (! XMLName::find(name, atom))
+        return false;
+
+    for (auto prop : m_proplist)
     {
-        if ((*iter)->name() == name && (*iter)->value() == value)
+        if (prop->atom() == atom && prop->value() == value)
             return true;
-
-        ++iter;
     }
     return false;
 }
@@ -742,17 +2975,26 @@ XMLNode::has_property_with_value
 bool
 XMLNode::set_property (const char * name, const std::string & value)
 {
+    need_properties();
     XMLPropertyIterator iter { m_proplist.begin() };
 #if 0
     std::string const v = PBD::sanitize_utf8 (value);           // PBD
 #endif
-    std::string v { value };
     std::string tmp;
-    utf8::replace_invalid(v.begin(), v.end(), std::back_inserter(tmp));
-    v = tmp;
+    bool valid { utf8::simd::is_valid(value) };
+    if (! valid)
+    {
+        utf8::replace_invalid
+        (
+            value.begin(), value.end(), std::back_inserter(tmp)
+        );
+    }
+
+    const std::string & v { valid ? value : tmp };
+    XMLName atom { name };
     while (iter != m_proplist.end())
     {
-        if ((*iter)->name() == name)
+        if ((*iter)->atom() == atom)
         {
             (*iter)->set_value(v);
             return *iter;
@@ -760,12 +3002,43 @@ XMLNode::set_property (const char * name, const std::string & value)
         ++iter;
     }
 
-    XMLProperty * new_property { new XMLProperty(name, v) };
-    if (is_nullptr(new_property))
-        return 0;
+    XMLProperty * prop { m_proplist.push_back(atom, v, own_arena()) };
+    prop->m_owner = this;
+    if (XMLEdits::tracked(m_edits))
+        m_edits->property(*this, atom, nullptr, &prop->value());
+
+    return true;
+}
+
+/**
+ *  Appends a property without sanitizing the value and without looking for
+ *  an existing property of the same name.  This is for trusted input only,
+ *  such as the attributes that libxml2 or XMLParser has already checked:
+ *  the value must be valid UTF-8 and the name must not be present yet.
+ *
+ *  It is private to XMLNode; only the readers (see the friends of XMLNode)
+ *  may use it.
+ *
+ *  Well-formed XML guarantees unique attribute names, but two attributes
+ *  in different namespaces can share a local name.  So once a namespaced
+ *  attribute is seen, the readers switch to set_property() for the rest
+ *  of the element.
+ */
+
+void
+XMLNode::add_property_nocheck (const char * name, const std::string & value)
+{
+    add_property_nocheck(XMLName(name), value);
+}
 
-    m_proplist.insert(m_proplist.end(), new_property);
-    return new_property;
+void
+XMLNode::add_property_nocheck (XMLName name, const std::string & value)
+{
+    need_properties();
+    XMLProperty * prop { m_proplist.push_back(name, value, own_arena()) };
+    prop->m_owner = this;
+    if (XMLEdits::tracked(m_edits))
+        m_edits->property(*this, name, nullptr, &prop->value());
 }
 
 bool
@@ -782,14 +3055,25 @@ XMLNode::get_property (const char * name, std::string & value) const
 void
 XMLNode::remove_property (const std::string & name)
 {
+    need_properties();
+    XMLName atom;
+    if (! XMLName::find(name, atom))
+        return;
+
     XMLPropertyIterator iter { m_proplist.begin() };
     while (iter != m_proplist.end())
     {
-        if ((*iter)->name() == name)
+        if ((*iter)->atom() == atom)
         {
-            XMLProperty * property { *iter };
-            m_proplist.erase(iter);
-            delete property;
+            if (XMLEdits::tracked(m_edits))
+            {
+                std::string before { (*iter)->value() };
+                (void) m_proplist.erase(iter);
+                m_edits->property(*this, atom, &before, nullptr);
+            }
+            else
+                (void) m_proplist.erase(iter);
+
             break;
         }
         ++iter;
@@ -803,6 +3087,7 @@ XMLNode::remove_property (const std::string & name)
 void
 XMLNode::remove_property_recursively (const std::string & n)
 {
+    need_children();
     remove_property(n);
     for (auto i : m_children)
     {
@@ -813,11 +3098,24 @@ XMLNode::remove_property_recursively (const std::string & n)
 void
 XMLNode::remove_nodes (const std::string & n)
 {
+    need_children();
+    XMLName atom;
+    if (! XMLName::find(n, atom))
+        return;
+
     XMLNodeIterator i { m_children.begin() };
     while (i != m_children.end())
     {
-        if ((*i)->name() == n)
+        if ((*i)->m_name == atom)
+        {
+            XMLNode * child { *i };
+            child->materialize();       /* it may outlive the lazy xmlDoc   */
+            disown(*child);
             i = m_children.erase (i);
+            drop_child_index();
+            if (not_nullptr(child->m_edits))
+                child->join(nullptr);   /* no longer part of the tree       */
+        }
         else
             ++i;
     }
@@ -826,13 +3124,20 @@ XMLNode::remove_nodes (const std::string & n)
 void
 XMLNode::remove_nodes_and_delete (const std::string & n)
 {
+    need_children();
+    XMLName atom;
+    if (! XMLName::find(n, atom))
+        return;
+
     XMLNodeIterator i { m_children.begin() };
     while (i != m_children.end())
     {
-        if ((*i)->name() == n)
+        if ((*i)->m_name == atom)
         {
+            disown(**i);
             delete *i;
             i = m_children.erase (i);
+            drop_child_index();
         }
         else
             ++i;
@@ -846,14 +3151,17 @@ XMLNode::remove_nodes_and_delete
     const std::string & val
 )
 {
+    need_children();
     XMLNodeIterator i { m_children.begin() };
     while (i != m_children.end())
     {
         XMLProperty const * prop = (*i)->property(propname);
         if (not_nullptr(prop) && prop->value() == val)
         {
+            disown(**i);
             delete *i;
             i = m_children.erase(i);
+            drop_child_index();
         }
         else
             ++i;
@@ -868,46 +3176,71 @@ XMLNode::remove_node_and_delete
     const std::string & val
 )
 {
+    need_children();
+    XMLName atom;
+    if (! XMLName::find(n, atom))
+        return;
+
     for (XMLNodeIterator i = m_children.begin(); i != m_children.end(); ++i)
     {
-        if ((*i)->name() == n)
+        if ((*i)->m_name == atom)
         {
             XMLProperty const * prop = (*i)->property (propname);
             if (not_nullptr(prop) && prop->value() == val)
             {
+                disown(**i);
                 delete *i;
                 m_children.erase(i);
+                drop_child_index();
                 break;
             }
         }
     }
 }
 
-static XMLSharedNodeList *
-find_impl (xmlXPathContext * ctxt, const std::string & xpath)
+/**
+ *  Evaluates a compiled query with libxml2.  The caller frees the context
+ *  and its document, even if this function throws; the document may be
+ *  the tree's own m_doc.
+ *
+ * \return
+ *      Returns the result, which the caller frees.  It is a node-set, which
+ *      may be empty.
+ */
+
+static xmlXPathObject *
+eval_nodeset (xmlXPathContext * ctxt, const XMLQuery & query)
 {
     xmlXPathObject * result
     {
-        xmlXPathEval((const xmlChar *) CSTR(xpath), ctxt)
+        xmlXPathCompiledEval(query.compiled(), ctxt)
     };
     if (is_nullptr(result))
-    {
-        xmlFreeDoc(ctxt->doc);
-        xmlXPathFreeContext(ctxt);
-        throw XMLException("Invalid XPath: " + xpath);
-    }
+        throw XMLException("Invalid XPath: " + query.text());
+
     if (result->type != XPATH_NODESET)
     {
         xmlXPathFreeObject(result);
-        xmlFreeDoc(ctxt->doc);
-        xmlXPathFreeContext(ctxt);
         throw XMLException("Only nodeset result types are supported.");
     }
+    return result;
+}
+
+/**
+ *  Evaluates a compiled query with libxml2 and copies the selected nodes.
+ *  As with eval_nodeset(), the caller frees the context.
+ */
+
+static XMLSharedNodeList *
+find_impl (xmlXPathContext * ctxt, const XMLQuery & query)
+{
+    xmlXPathObject * result { eval_nodeset(ctxt, query) };
 
     xmlNodeSet * nodeset { result->nodesetval };
     XMLSharedNodeList * nodes { new XMLSharedNodeList() };
     if (nodeset)
     {
+        XMLEdits::quiet copying;        /* copies are new nodes, not edits  */
         for (int i = 0; i < nodeset->nodeNr; ++i)
         {
             XMLNode * node = readnode(nodeset->nodeTab[i]);
@@ -929,18 +3262,19 @@ find_impl (xmlXPathContext * ctxt, const std::string & xpath)
 void
 XMLNode::dump (std::ostream & s, const std::string & p) const
 {
+    need_children();
     if (m_is_content)
     {
         s << p << "  " << content() << "\n";
     }
     else
     {
-        s << p << "<" << m_name << ">\n";
+        s << p << "<" << name() << ">\n";
         for (auto i : m_children)
         {
             i->dump (s, p + "  ");
         }
-        s << p << "</" << m_name << ">\n";
+        s << p << "</" << name() << ">\n";
     }
 }
 
@@ -24,19 +24,30 @@
  * \library       xml66
  * \author        Chris Ahlstrom
  * \date          2026-02-20
- * \updates       2026-02-24
+ * \updates       2026-10-16
  * \license       See above.
  *
  *  To do: add a help-line for each option.
  */
 
+#include <algorithm>                    /* std::min()                       */
 #include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+#include <cstring>                      /* std::strlen()                    */
+#include <fstream>                      /* std::ifstream                    */
 #include <iomanip>                      /* std::setw()                      */
 #include <iostream>                     /* std::cout, std::cerr             */
+#include <sstream>                      /* std::ostringstream               */
 #include <string>                       /* std::string                      */
+#include <thread>                       /* std::thread                      */
+#include <vector>                       /* std::vector<>                    */
 
 #include "cli/parser.hpp"               /* cli::parser, etc.                */
+#include "utfcpp/utf8.h"                /* utf8::replace_invalid()          */
 #include "xml66.hpp"                    /* xml66_version() function         */
+#if defined XML66_USE_NATIVE_PARSER
+#include "xml/xml66parser.hpp"          /* xml66::XMLParser class           */
+#endif
+#include "xml/xml66stream.hpp"          /* xml66::XMLStream class           */
 #include "xml/xml66xx.hpp"              /* xml66::XMLnnn classes            */
 
 namespace   // anonymous
@@ -445,6 +456,1584 @@ basic_test_7 (bool verbose)
     return result;
 }
 
+/*
+ * The test data files, used by the tests that check every file.
+ */
+
+static const char * const s_test_files [] =
+{
+    "tests/data/RosegardenPatchFile.xml",
+    "tests/data/TestSession.ardour",
+    "tests/data/ProtoolsPatchFile.midnam"
+};
+
+bool
+basic_test_8 (bool verbose)
+{
+    using ingest = xml66::XMLTree::ingest;
+    bool result { true };
+    std::cout
+        << "Test 8: Alternate reads match document reads."
+        << std::endl
+        ;
+    for (auto testfile : s_test_files)
+    {
+        xml66::XMLTree doc(testfile);
+        xml66::XMLTree buffered;
+        buffered.set_mmap_threshold(0);         /* never memory-map it      */
+        result = buffered.read(testfile) && *doc.root() == *buffered.root();
+        if (! result)
+        {
+            std::cout << "   " << testfile << " (buffered): MISMATCH\n";
+            break;
+        }
+        for (auto mode : { ingest::streaming, ingest::lazy, ingest::native })
+        {
+            xml66::XMLTree other(testfile, mode);
+            result = not_nullptr(doc.root()) && not_nullptr(other.root());
+            if (result)
+                result = *doc.root() == *other.root();
+
+            if (verbose || ! result)
+            {
+                std::cout
+                    << "   " << testfile
+                    << (mode == ingest::lazy ? " (lazy): " :
+                        mode == ingest::native ? " (native): " : " (stream): ")
+                    << (result ? "match" : "MISMATCH") << std::endl
+                    ;
+            }
+            if (! result)
+                break;
+        }
+        if (! result)
+            break;
+    }
+    if (result)
+    {
+        xml66::XMLTree stream
+        (
+            "tests/data/TestSession.ardour", xml66::XMLTree::ingest::streaming
+        );
+        xml66::SharedNodeListPtr nodeptrs
+        {
+            stream.find
+            (
+                "/Session/Sources/Source[contains(@captured-for, 'Guitar')]"
+            )
+        };
+        std::size_t count { not_nullptr(nodeptrs) ? nodeptrs->size() : 0 };
+        result = count == 16;
+        std::cout
+            << "Found " << count << " sources without an xmlDoc."
+            << std::endl
+            ;
+    }
+    return result;
+}
+
+/*
+ * Reads a whole file into a string.
+ */
+
+std::string
+file_contents (const std::string & filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+bool
+basic_test_9 (bool verbose)
+{
+    bool result { true };
+    std::cout
+        << "Test 9: Parse buffers that are not NUL-terminated."
+        << std::endl
+        ;
+
+    xml66::XMLTree tree;
+    for (auto testfile : s_test_files)
+    {
+        /*
+         * The trailing junk must not be seen by the parser.
+         */
+
+        xml66::XMLTree doc(testfile);
+        std::string text { file_contents(testfile) };
+        std::size_t len { text.size() };
+        text += "<junk";
+        result = tree.read_buffer_n(text.data(), len);
+        if (result)
+            result = *doc.root() == *tree.root();
+
+        if (verbose || ! result)
+        {
+            std::cout
+                << "   " << testfile << ": "
+                << (result ? "match" : "MISMATCH") << std::endl
+                ;
+        }
+        if (! result)
+            break;
+    }
+    if (result)
+    {
+        std::string_view text { "<a><b n='1'/><b n='2'/></a><junk" };
+        result = tree.read_buffer(text.substr(0, 27), true);
+        if (result)
+        {
+            xml66::SharedNodeListPtr nodeptrs { tree.find("/a/b[@n='2']") };
+            result = nodeptrs->size() == 1;
+        }
+    }
+    return result;
+}
+
+/*
+ * Exercises the whitespace and entity handling that the native parser must
+ * reproduce from libxml2.  Without the native parser, both reads use
+ * libxml2.  Malformed documents must be rejected by both the native parser
+ * and libxml2, so that the fallback reports the error.
+ */
+
+bool
+basic_test_10 (bool verbose)
+{
+    std::cout
+        << "Test 10: Native reads match libxml2 on tricky content."
+        << std::endl
+        ;
+
+    static const char * const s_docs [] =
+    {
+        "<a x='1&amp;2\t3'>\r\n  <b/> mixed &lt;text&gt; <c>&#233;</c>\n</a>",
+        "<a><![CDATA[ one ]]>  <![CDATA[two]]><!-- note --><?pi data?></a>",
+        "<a xml:space='preserve'>  <b>\r\n\r\n</b>\r <c/>  </a>",
+        "<a xmlns:q='urn:q'><q:b q:n='v'/>\r<c>\t</c></a>"
+    };
+    bool result { true };
+    for (auto text : s_docs)
+    {
+        xml66::XMLTree doc;
+        xml66::XMLTree native;
+        native.set_ingest_mode(xml66::XMLTree::ingest::native);
+        result = doc.read_buffer(text) && native.read_buffer(text);
+        if (result)
+            result = *doc.root() == *native.root();
+
+        if (verbose || ! result)
+        {
+            std::cout
+                << "   " << (result ? "match" : "MISMATCH") << std::endl
+                ;
+        }
+        if (! result)
+            break;
+    }
+
+    static const char * const s_malformed [] =
+    {
+        "<a$/>",
+        "<1a/>",
+        "<a b$='1'/>",
+        "<a><!-- a -- b --></a>",
+        "<a><!-- a ---></a>",
+        "<a>]]></a>",
+        "<a><?xml foo?></a>",
+        "<a/><!DOCTYPE a>",
+        "<!DOCTYPE a><!DOCTYPE a><a/>",
+        "<?xml encoding=\"UTF-8\"?><a/>",
+        "<?xml version=\"1.0\"?><?xml version=\"1.0\"?><a/>",
+        "<a>\xEF\xBF\xBE</a>",
+        "<a b='\xEF\xBF\xBF'/>",
+        "<?xml version='1.0' encoding='US-ASCII'?><a>\xC3\xA9</a>",
+        "<a><![CDATA[\x01]]></a>"
+    };
+    for (auto text : s_malformed)
+    {
+        if (! result)
+            break;
+
+        xml66::XMLTree doc;
+        bool rejected { ! doc.read_buffer(text) };
+#if defined XML66_USE_NATIVE_PARSER
+        xml66::XMLParser parser { text, std::strlen(text) };
+        xml66::XMLNode * root { parser.parse() };
+        rejected = rejected && is_nullptr(root);
+        delete root;
+#endif
+        result = rejected;
+        if (verbose || ! result)
+        {
+            std::cout
+                << "   " << (result ? "rejected" : "ACCEPTED") << ": "
+                << text << std::endl
+                ;
+        }
+    }
+    return result;
+}
+
+/*
+ * Valid values are stored as is; invalid UTF-8 is still replaced.
+ */
+
+bool
+basic_test_11 (bool verbose)
+{
+    std::cout
+        << "Test 11: set_property() keeps valid UTF-8 and repairs the rest."
+        << std::endl
+        ;
+
+    std::string ascii(100, 'a');
+    std::string mixed { ascii + "\xC3\xA9t\xC3\xA9" + ascii };
+    std::string invalid { ascii + "\xC3" + ascii + "\xFF" };
+    std::string repaired;
+    utf8::replace_invalid
+    (
+        invalid.begin(), invalid.end(), std::back_inserter(repaired)
+    );
+
+    xml66::XMLNode node("node");
+    node.set_property("ascii", ascii);
+    node.set_property("mixed", mixed);
+    node.set_property("invalid", invalid);
+    bool result
+    {
+        node.property("ascii")->value() == ascii &&
+        node.property("mixed")->value() == mixed &&
+        node.property("invalid")->value() == repaired &&
+        repaired != invalid
+    };
+    if (verbose || ! result)
+        std::cout << "   " << (result ? "ok" : "FAILED") << std::endl;
+
+    return result;
+}
+
+/*
+ * Feeds each file in small chunks of odd sizes, as from a pipe.
+ */
+
+bool
+basic_test_12 (bool verbose)
+{
+    bool result { true };
+    std::cout
+        << "Test 12: Incremental reads match document reads."
+        << std::endl
+        ;
+
+    std::size_t chunksize { 7 };
+    for (auto testfile : s_test_files)
+    {
+        xml66::XMLTree doc(testfile);
+        std::string text { file_contents(testfile) };
+        xml66::XMLTree tree;
+        result = tree.begin(chunksize > 100);
+        for (std::size_t pos = 0; result && pos < text.size(); )
+        {
+            std::size_t count { std::min(chunksize, text.size() - pos) };
+            result = tree.feed(text.data() + pos, count);
+            pos += count;
+        }
+        if (result)
+            result = tree.finish();
+
+        if (result)
+            result = *doc.root() == *tree.root();
+
+        if (verbose || ! result)
+        {
+            std::cout
+                << "   " << testfile << " (" << chunksize << "-byte chunks): "
+                << (result ? "match" : "MISMATCH") << std::endl
+                ;
+        }
+        if (! result)
+            break;
+
+        chunksize = chunksize * 31 + 1;
+    }
+    return result;
+}
+
+/*
+ * Loads each test file several times over, on several threads.
+ */
+
+bool
+basic_test_13 (bool verbose)
+{
+    std::cout
+        << "Test 13: Parallel batch loads match single loads."
+        << std::endl
+        ;
+
+    std::vector<std::string> paths;
+    for (int copy = 0; copy < 8; ++copy)
+    {
+        for (auto testfile : s_test_files)
+            paths.push_back(testfile);
+    }
+
+    xml66::XMLTreeList trees { xml66::XMLTree::load_all(paths, 4) };
+    bool result { trees.size() == paths.size() };
+    for (std::size_t i = 0; result && i < paths.size(); ++i)
+    {
+        xml66::XMLTree doc(paths[i]);
+        result = not_nullptr(trees[i]->root()) &&
+            *doc.root() == *trees[i]->root();
+    }
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << paths.size() << " files: "
+            << (result ? "match" : "MISMATCH") << std::endl
+            ;
+    }
+    return result;
+}
+
+/*
+ * Many small parses through one explicit pool reuse a single context.
+ */
+
+bool
+basic_test_14 (bool verbose)
+{
+    std::cout
+        << "Test 14: Parser contexts are reused from a pool."
+        << std::endl
+        ;
+
+    xml66::XMLParserPool pool { 2 };
+    bool result { true };
+    for (int i = 0; result && i < 100; ++i)
+    {
+        xml66::XMLTree tree;
+        tree.set_parser_pool(&pool);
+        std::string text
+        {
+            "<a n='" + std::to_string(i) + "'><b/></a>"
+        };
+        result = tree.read_buffer(text, i % 2 == 0);
+        if (result)
+            result = tree.root()->property("n")->value() == std::to_string(i);
+    }
+    if (result)
+        result = pool.idle() == 1;
+
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << pool.idle() << " idle context(s): "
+            << (result ? "ok" : "FAILED") << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Tests that names are interned: equal names share one atom, and looking
+ *  up a name no node has does not add it to the table.
+ */
+
+bool
+basic_test_15 (bool verbose)
+{
+    std::cout
+        << "Test 15: Element and attribute names are interned."
+        << std::endl
+        ;
+
+    xml66::XMLTree tree;
+    bool result
+    {
+        tree.read_buffer("<a id='1'><port id='2'/><port id='3'/></a>")
+    };
+    if (result)
+    {
+        const xml66::XMLNodeList & ports { tree.root()->children("port") };
+        result = ports.size() == 2 &&
+            ports.front()->atom() == ports.back()->atom() &&
+            ports.front()->property("id")->atom() ==
+                tree.root()->property("id")->atom();
+    }
+    if (result)
+    {
+        std::size_t count { xml66::XMLName::table_size() };
+        result = tree.root()->property("no-such-attribute") == nullptr &&
+            tree.root()->child("no-such-element") == nullptr &&
+            xml66::XMLName::table_size() == count;
+    }
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << xml66::XMLName::table_size() << " names: "
+            << (result ? "ok" : "FAILED") << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Tests arena mode: trees read into an arena match heap trees, a re-read
+ *  reuses the arena, and heap and arena nodes mix in one tree.
+ */
+
+bool
+basic_test_16 (bool verbose)
+{
+    using ingest = xml66::XMLTree::ingest;
+    std::cout
+        << "Test 16: Arena-mode reads match heap reads."
+        << std::endl
+        ;
+
+    bool result { true };
+    for (auto testfile : s_test_files)
+    {
+        xml66::XMLTree doc(testfile);
+        for
+        (
+            auto mode : { ingest::document, ingest::streaming, ingest::native }
+        )
+        {
+            xml66::XMLTree arena;
+            arena.set_arena_mode(true);
+            arena.set_ingest_mode(mode);
+            result = arena.read(testfile) && *doc.root() == *arena.root();
+            if (result)
+            {
+                std::size_t bytes { arena.arena()->bytes() };
+                result = bytes > 0 && arena.read(testfile) &&
+                    arena.arena()->bytes() == bytes;
+            }
+            if (verbose || ! result)
+            {
+                std::cout
+                    << "   " << testfile << " (" << int(mode) << "): "
+                    << (result ? "match" : "MISMATCH") << std::endl
+                    ;
+            }
+            if (! result)
+                break;
+        }
+        if (! result)
+            break;
+    }
+    if (result)
+    {
+        xml66::XMLTree tree;
+        tree.set_arena_mode(true);
+        result = tree.read_buffer("<a><b/><c/></a>");
+        if (result)
+        {
+            tree.root()->add_child("d");                /* from the heap    */
+            tree.root()->remove_nodes_and_delete("b");  /* from the arena   */
+            result = tree.root()->children().size() == 2;
+        }
+        if (result)
+        {
+            /*
+             * Long strings are on the heap even for arena nodes, so these
+             * nodes must still be destroyed when the arena is released.
+             */
+
+            result = tree.read_buffer
+            (
+                "<a x='a value too long to be a small string'>"
+                "<b/>a text node too long to be a small string<c y='1'/></a>"
+            );
+            if (result)
+                result = tree.root()->children().size() == 3;
+        }
+        tree.set_arena_mode(false);
+        if (result)
+            result = tree.read_buffer("<a/>") && is_nullptr(tree.arena());
+    }
+    return result;
+}
+
+/**
+ *  Tests that property pointers stay valid as properties are added past
+ *  the inline slots and removed, and that removed ones are not listed.
+ */
+
+bool
+basic_test_17 (bool verbose)
+{
+    std::cout
+        << "Test 17: Property pointers are stable."
+        << std::endl
+        ;
+
+    xml66::XMLNode node { "n" };
+    (void) node.set_property("p0", "v0");
+    xml66::XMLProperty * first { node.property("p0") };
+    for (int i = 1; i < 10; ++i)
+    {
+        std::string i_str { std::to_string(i) };
+        (void) node.set_property(("p" + i_str).c_str(), "v" + i_str);
+    }
+    xml66::XMLProperty * last { node.property("p9") };
+    xml66::XMLProperty * second { node.property("p1") };
+    xml66::XMLProperty * sixth { node.property("p5") };
+    node.remove_property("p1");
+    node.remove_property("p5");
+    (void) node.set_property("p0", "changed");
+
+    std::string names;
+    for (auto prop : node.properties())
+        names += prop->name();
+
+    bool result
+    {
+        first == node.property("p0") && first->value() == "changed" &&
+        last == node.property("p9") && last->value() == "v9" &&
+        node.properties().size() == 8 && names == "p0p2p3p4p6p7p8p9" &&
+        node.property("p5") == nullptr
+    };
+
+    xml66::XMLNode copy { node };
+    if (result)
+        result = copy == node && copy.properties().size() == 8;
+
+    if (result)                         /* erased slots are reused          */
+    {
+        (void) node.set_property("p1", "again");
+        xml66::XMLProperty * p1 { node.property("p1") };
+        result = p1 == second || p1 == sixth;
+        for (int i = 0; result && i < 100; ++i)
+        {
+            (void) node.set_property("tmp", std::to_string(i));
+            xml66::XMLProperty * tmp { node.property("tmp") };
+            node.remove_property("tmp");
+            (void) node.set_property("tmp", "x");
+            result = node.property("tmp") == tmp;
+            node.remove_property("tmp");
+        }
+        names.clear();
+        for (auto prop : node.properties())
+            names += prop->name();
+
+        if (result)
+            result = names == "p0p2p3p4p6p7p8p9p1";
+    }
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << names << ", sizeof(XMLNode) " << sizeof(xml66::XMLNode)
+            << ": " << (result ? "ok" : "FAILED")
+            << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Tests that a frozen tree holds the same document: thawing it gives an
+ *  equal XMLNode tree, and the handle getters match the node getters.
+ */
+
+bool
+basic_test_18 (bool verbose)
+{
+    std::cout
+        << "Test 18: Frozen trees match their XMLNode trees."
+        << std::endl
+        ;
+
+    bool result { true };
+    for (auto testfile : s_test_files)
+    {
+        xml66::XMLTree doc(testfile);
+        xml66::XMLFrozenTree frozen { doc.freeze() };
+        xml66::XMLNode * thawed { frozen.root().thaw() };
+        result = *thawed == *doc.root();
+        delete thawed;
+        if (verbose || ! result)
+        {
+            std::cout
+                << "   " << testfile << ": " << frozen.size() << " nodes, "
+                << frozen.memory_bytes() << " bytes: "
+                << (result ? "match" : "MISMATCH") << std::endl
+                ;
+        }
+        if (! result)
+            break;
+    }
+    if (result)
+    {
+        xml66::XMLTree tree;
+        result = tree.read_buffer("<a x='1'><b y='2'>text</b><c/></a>");
+        if (result)
+        {
+            xml66::XMLFrozenTree frozen { tree.freeze() };
+            xml66::XMLFrozenNode a { frozen.root() };
+            xml66::XMLFrozenNode b { a.child("b") };
+            int y { 0 };
+            result = a.name() == "a" && a.has_property_with_value("x", "1") &&
+                b && b.get_property("y", y) && y == 2 &&
+                b.child_content() == "text" && b.parent() == a &&
+                b.next_sibling().name() == "c" && ! a.child("none") &&
+                ! b.next_sibling().next_sibling();
+        }
+    }
+    return result;
+}
+
+/**
+ *  Tests moving nodes: a tree built with emplace_child() and moved
+ *  subtrees matches one built with copies, and moved-from nodes are empty.
+ */
+
+bool
+basic_test_19 (bool verbose)
+{
+    std::cout
+        << "Test 19: Nodes can be moved instead of copied."
+        << std::endl
+        ;
+
+    xml66::XMLNode copied { "root" };
+    xml66::XMLNode moved { "root" };
+    for (int i = 0; i < 10; ++i)
+    {
+        xml66::XMLNode item { "item" };
+        (void) item.set_property("index", i);
+        (void) item.add_content("text " + std::to_string(i));
+        (void) item.add_child("leaf");
+        (void) copied.add_child_copy(item);
+
+        xml66::XMLNode * leaf { item.child("leaf") };
+        xml66::XMLNode * added { moved.add_child(std::move(item)) };
+        bool ok
+        {
+            item.children().empty() && item.properties().empty() &&
+            added->child("leaf") == leaf
+        };
+        if (! ok)
+        {
+            std::cout << "   moved-from node not empty: FAILED" << std::endl;
+            return false;
+        }
+    }
+
+    xml66::XMLNode emplaced { "root" };
+    for (int i = 0; i < 10; ++i)
+    {
+        xml66::XMLNode * item { emplaced.emplace_child("item") };
+        (void) item->set_property("index", i);
+        (void) item->emplace_child(std::string(), "text " + std::to_string(i));
+        (void) item->emplace_child("leaf");
+    }
+
+    xml66::XMLNode assigned { "other" };
+    assigned = std::move(emplaced);
+
+    bool result { copied == moved && copied == assigned };
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << moved.children().size() << " children: "
+            << (result ? "match" : "MISMATCH") << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Tests lookups by name in a node large enough to index its children, as
+ *  children are added and removed.
+ */
+
+bool
+basic_test_20 (bool verbose)
+{
+    std::cout
+        << "Test 20: Child lookups by name in large nodes."
+        << std::endl
+        ;
+
+    xml66::XMLNode set { "ChannelNameSet" };
+    for (int i = 0; i < 100; ++i)
+    {
+        xml66::XMLNode * child { set.add_child(i % 3 == 0 ? "Patch" : "Note") };
+        (void) child->set_property("n", i);
+    }
+    bool result
+    {
+        set.children("Patch").size() == 34 &&
+        set.children("Note").size() == 66 &&
+        set.children("Other").empty() &&
+        set.child("Patch") == set.children().front() &&
+        set.child("Note") == set.children()[1]
+    };
+    if (result)
+    {
+        (void) set.add_child("Other");                  /* index is updated */
+        xml66::XMLNode other { "Patch" };
+        (void) set.add_child(std::move(other));
+        result = set.children("Other").size() == 1 &&
+            set.children("Patch").size() == 35;
+    }
+    if (result)
+    {
+        set.remove_nodes_and_delete("Note");            /* index is dropped */
+        result = set.children("Note").empty() && set.child("Note") == nullptr &&
+            set.children("Patch").size() == 35 &&
+            set.children().size() == 36;
+    }
+    if (result)
+    {
+        xml66::XMLNode * first { set.children()[0] };   /* renamed children */
+        xml66::XMLNode * second { set.children()[1] };
+        xml66::XMLNode note { "Note" };
+        *first = xml66::XMLNode("Note");
+        *second = std::move(note);
+        result = set.children("Patch").size() == 33 &&
+            set.children("Note").size() == 2 && set.child("Note") == first;
+        if (result)
+        {
+            xml66::XMLNode taken { std::move(*first) };
+            result = set.children("Note").size() == 1 &&
+                set.child("Note") == second;
+        }
+    }
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << set.children().size() << " children: "
+            << (result ? "ok" : "FAILED") << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Counts the descendants of a node with a given name, using only the
+ *  lookups that are safe on a shared tree.
+ */
+
+std::size_t
+count_named (const xml66::XMLNode & node, const std::string & name)
+{
+    std::size_t result { node.children(name).size() };
+    for (auto child : node.children_where
+        (
+            [] (const xml66::XMLNode * n) { return ! n->is_content(); }
+        ))
+    {
+        result += count_named(*child, name);
+    }
+    return result;
+}
+
+/**
+ *  Tests the child views, and that several threads can look up children
+ *  by name in one tree at the same time.
+ */
+
+bool
+basic_test_21 (bool verbose)
+{
+    std::cout
+        << "Test 21: Child views and shared const lookups."
+        << std::endl
+        ;
+
+    xml66::XMLTree tree { "tests/data/ProtoolsPatchFile.midnam" };
+    xml66::XMLNode * root { tree.root() };
+    bool result { not_nullptr(root) };
+    if (result)
+    {
+        const xml66::XMLNodeList & all { root->children() };
+        std::size_t views { 0 };
+        for (auto child : all)
+        {
+            views += root->children_named(child->name()).size();
+            for (auto same : root->children_named(child->name()))
+                result = result && same->name() == child->name();
+        }
+        result = result && views > 0 &&
+            root->children_named("no-such-element").empty() &&
+            root->children_where
+            (
+                [] (const xml66::XMLNode *) { return true; }
+            ).size() == all.size();
+    }
+
+    std::size_t expected { result ? count_named(*root, "Patch") : 0 };
+    if (result)
+    {
+        xml66::XMLTree shared { "tests/data/ProtoolsPatchFile.midnam" };
+        std::vector<std::size_t> counts(4, 0);
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < counts.size(); ++t)
+        {
+            workers.emplace_back
+            (
+                [&shared, &counts, t] ()
+                {
+                    counts[t] = count_named(*shared.root(), "Patch");
+                }
+            );
+        }
+        for (auto & w : workers)
+            w.join();
+
+        for (auto c : counts)
+            result = result && c == expected;
+    }
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << expected << " Patch elements: "
+            << (result ? "ok" : "FAILED") << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  True if two nodes have the same names, properties, and content, down
+ *  through their children.
+ */
+
+bool
+same_nodes (const xml66::XMLNode & a, const xml66::XMLNode & b)
+{
+    if
+    (
+        a.name() != b.name() || a.content() != b.content() ||
+        a.properties().size() != b.properties().size() ||
+        a.children().size() != b.children().size()
+    )
+    {
+        return false;
+    }
+    for (auto prop : a.properties())
+    {
+        const xml66::XMLProperty * other { b.property(prop->name()) };
+        if (is_nullptr(other) || other->value() != prop->value())
+            return false;
+    }
+    auto bi { b.children().begin() };
+    for (auto child : a.children())
+    {
+        if (! same_nodes(*child, **bi++))
+            return false;
+    }
+    return true;
+}
+
+/**
+ *  Tests that XPath expressions evaluated on the XMLNode tree give the
+ *  same nodes as libxml2 does on the document, including the conversions
+ *  between numbers and strings.
+ */
+
+bool
+basic_test_22 (bool verbose)
+{
+    std::cout
+        << "Test 22: Native XPath matches libxml2."
+        << std::endl
+        ;
+
+    static const char * const s_expressions [] =
+    {
+        "//Patch[@Name]",
+        "//@Value",
+        "/MIDINameDocument//PatchBank[2]//Patch[last()]",
+        "//PatchBank[count(.//Patch) > 100]/@Name",
+        "//Patch[contains(@Name, 'Piano')][1]",
+        "//Patch[starts-with(@Name, 'B') and @Number > 5]",
+        "//ControlChange[@Control = '0'][@Value != 0]/..",
+        "//Patch[3]/following-sibling::Patch[position() < 3]",
+        "//Patch[@Number = 10]/ancestor::*/@Name",
+        "//Author/text() | //Manufacturer"
+    };
+    xml66::XMLTree doc { "tests/data/ProtoolsPatchFile.midnam" };
+    bool result { not_nullptr(doc.root()) };
+    std::size_t total { 0 };
+    for (auto xpath : s_expressions)
+    {
+        if (! result)
+            break;
+
+        xml66::SharedNodeListPtr expected { doc.find(xpath) };
+        xml66::SharedNodeListPtr actual { doc.find(xpath, doc.root()) };
+        result = xml66::XMLXPath::compile(xpath) != nullptr &&
+            ! expected->empty() && actual->size() == expected->size();
+
+        for (std::size_t i = 0; result && i < actual->size(); ++i)
+            result = same_nodes(*(*actual)[i], *(*expected)[i]);
+
+        total += actual->size();
+        if (verbose || ! result)
+        {
+            std::cout
+                << "   " << xpath << ": " << actual->size() << " nodes"
+                << std::endl
+                ;
+        }
+    }
+    if (result)
+    {
+        static const char * const s_numbers [] =
+        {
+            "//p[@n = 1000]",
+            "//p[@n = 1e3]",
+            "//p[@n > 0]",
+            "//p[@n > 2]/@n",
+            "//p[string(@n * 1) = '1e+20']",
+            "//p[string(@n + 0.2) = '0.3']",
+            "//p[string(@n div 3) = '0.833333333333333']"
+        };
+        xml66::XMLTree numbers;
+        result = numbers.read_buffer
+        (
+            "<r><p n='1e3'/><p n='0.1'/><p n='2.5'/><p n='-'/><p n='1E20'/>"
+            "<p n=' 7 '/><p n='.'/><p n='abc'/><p n='-2e-1'/></r>", true
+        );
+        for (auto xpath : s_numbers)
+        {
+            if (! result)
+                break;
+
+            std::size_t expected { numbers.find(xpath)->size() };
+            std::size_t actual { numbers.find(xpath, numbers.root())->size() };
+            result = expected > 0 && actual == expected;
+            if (verbose || ! result)
+            {
+                std::cout
+                    << "   " << xpath << ": " << actual << " of "
+                    << expected << " nodes" << std::endl
+                    ;
+            }
+        }
+    }
+    if (result)
+    {
+        int errors { 0 };
+        for (auto xpath : { "count(//Patch)", "//Patch[" })
+        {
+            try
+            {
+                (void) doc.find(xpath, doc.root());
+            }
+            catch (const xml66::XMLException &)
+            {
+                ++errors;                       /* native, then libxml2     */
+            }
+        }
+        result = errors == 2 && ! xml66::XMLXPath::compile("//Patch[");
+    }
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << total << " nodes: "
+            << (result ? "ok" : "FAILED") << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Tests compiled queries and the least-recently-used query cache.
+ */
+
+bool
+basic_test_23 (bool verbose)
+{
+    std::cout
+        << "Test 23: Compiled queries and the query cache."
+        << std::endl
+        ;
+
+    xml66::XMLTree doc { "tests/data/RosegardenPatchFile.xml" };
+    xml66::XMLQueryCache & cache { doc.query_cache() };
+    cache.set_capacity(2);
+
+    const std::string banks { "//bank[@name]" };
+    xml66::XMLQuery programs { "//bank/program[@id < 3]" };
+    xml66::XMLQueryPtr first { doc.query(banks) };
+    std::size_t count { doc.find(programs)->size() };   /* via libxml2  */
+    bool result
+    {
+        doc.query(banks) == first && cache.size() == 1 &&
+        not_nullptr(first->native()) &&
+        doc.find(*first)->size() == doc.find(banks)->size() &&
+        doc.find(programs, doc.root())->size() == count && count == 12
+    };
+    if (result)
+    {
+        (void) doc.query("//program");
+        (void) doc.query(banks);                        /* now most recent  */
+        (void) doc.query("//instrument");               /* evicts program   */
+        result = cache.size() == 2 && doc.query(banks) == first;
+    }
+    if (result)
+    {
+        bool threw { false };
+        try
+        {
+            (void) doc.find("//bank[");
+        }
+        catch (const xml66::XMLException &)
+        {
+            threw = true;
+        }
+        result = threw && cache.size() == 2;
+    }
+    if (result)
+    {
+        cache.set_capacity(0);
+        result = cache.size() == 0 && doc.query(banks) != first &&
+            cache.size() == 0;
+    }
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << count << " programs: "
+            << (result ? "ok" : "FAILED") << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Tests that find_nodes() returns the nodes of the tree, natively and
+ *  through libxml2.
+ */
+
+bool
+basic_test_24 (bool verbose)
+{
+    std::cout
+        << "Test 24: Query results that reference the tree."
+        << std::endl
+        ;
+
+    xml66::XMLTree doc { "tests/data/TestSession.ardour" };
+    const std::string both { "//*[@id and @name]" };
+    xml66::XMLNodeRefList refs { doc.find_nodes(both) };
+    xml66::SharedNodeListPtr copies { doc.find(both) };
+    bool result { ! refs.empty() && refs.size() == copies->size() };
+    for (std::size_t i = 0; result && i < refs.size(); ++i)
+    {
+        result = is_nullptr(refs[i].property) &&
+            refs[i].node->name() == (*copies)[i]->name();
+    }
+    if (result)
+    {
+        xml66::XMLNode * first { refs.front().node };
+        (void) first->set_property("name", "renamed");
+        xml66::XMLNodeRefList again { doc.find_nodes("//*[@name='renamed']") };
+        result = again.size() == 1 && again.front().node == first;
+    }
+    if (result)
+    {
+        xml66::XMLNodeRefList names { doc.find_nodes("//Region/@name") };
+        xml66::XMLNodeRefList regions { doc.find_nodes("//Region") };
+        xml66::XMLNodeRefList second { doc.find_nodes("(//Region)[2]") };
+        result = ! names.empty() && regions.size() > 1 &&
+            names.front().property == regions.front().node->property("name") &&
+            second.size() == 1 && second.front().node == regions[1].node;
+    }
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << refs.size() << " nodes: "
+            << (result ? "ok" : "FAILED") << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Tests that find() without a node sees changes made to the nodes after
+ *  the document was read, natively and through libxml2, that a change to
+ *  one tree leaves another current, and that the xmlDoc patched for those
+ *  changes matches one written afresh.
+ */
+
+bool
+basic_test_25 (bool verbose)
+{
+    std::cout
+        << "Test 25: Queries see changes to the tree."
+        << std::endl
+        ;
+
+    xml66::XMLTree doc { "tests/data/TestSession.ardour" };
+    const std::string first { "(//Region)[1]" };            /* libxml2      */
+    std::size_t regions { doc.find("//Region")->size() };
+    bool result { doc.doc_current() && regions > 0 };
+    if (result)
+    {
+        xml66::XMLNodeRefList refs { doc.find_nodes(first) };
+        result = refs.size() == 1 && doc.doc_current();     /* no edits     */
+        if (result)
+        {
+            (void) refs.front().node->set_property("name", "edited");
+            result = ! doc.doc_current() &&
+                doc.find("//Region[@name='edited']")->size() == 1 &&
+                doc.find("(//Region[@name='edited'])[1]")->size() == 1;
+        }
+        if (result)
+        {
+            (void) refs.front().node->set_property("name", "again");
+            result =
+                doc.find("(//Region[@name='edited'])[1]")->empty() &&
+                doc.find("(//Region[@name='again'])[1]")->size() == 1;
+        }
+    }
+    if (result)
+    {
+        xml66::XMLNode * root { doc.root() };
+        (void) root->add_child("Extra");
+        result = doc.find("/*/Extra")->size() == 1 &&
+            doc.find("(/*/Extra)[1]")->size() == 1;
+        if (result)
+        {
+            root->remove_nodes_and_delete("Extra");
+            result = doc.find("/*/Extra")->empty() &&
+                doc.find("(/*/Extra)[1]")->empty() &&
+                doc.find("//Region")->size() == regions;
+        }
+    }
+    if (result)                         /* changes are tracked per tree     */
+    {
+        xml66::XMLTree other { "tests/data/TestSession.ardour" };
+        (void) doc.root()->set_property("touched", "yes");
+        result = other.doc_current();
+    }
+    if (result)                         /* the patched xmlDoc is exact      */
+    {
+        xml66::XMLNode * root { doc.root() };
+        xml66::XMLNode * extra { root->add_child("Extra") };
+        (void) extra->set_property("a", "1");
+        (void) extra->add_content("text");
+        (void) extra->add_child("Inner")->set_property("b", "2");
+        extra->remove_property("a");
+        (void) extra->set_property("c", "3");
+        (void) extra->children().front()->set_content("changed");
+        extra->remove_nodes_and_delete("Inner");
+        xml66::XMLNode * temp { extra->add_child("Temp") };
+        (void) temp->set_property("e", "6");
+        (void) temp->add_content("moved");
+        *root->add_child("Moved") = std::move(*temp);
+        (void) doc.find("(//*)[1]");    /* after the xmlDoc is written      */
+        (void) extra->add_child("Late")->set_property("d", "4");
+        (void) extra->set_property("c", "5");
+        root->remove_nodes_and_delete("Moved");
+
+        xml66::XMLTree fresh { &doc };
+        const std::vector<std::string> exprs
+        {
+            "(//*)[position() >= 1]",
+            "(//text())[position() >= 1]",
+            "(//@*)[position() >= 1]"
+        };
+        for (const auto & e : exprs)
+        {
+            xml66::SharedNodeListPtr expected { fresh.find(e) };
+            xml66::SharedNodeListPtr actual { doc.find(e) };
+            result = actual->size() == expected->size();
+            for (std::size_t i = 0; result && i < actual->size(); ++i)
+                result = same_nodes(*(*actual)[i], *(*expected)[i]);
+
+            if (! result)
+                break;
+        }
+    }
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << regions << " regions: "
+            << (result ? "ok" : "FAILED") << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Tests that find() with an attribute index matches find() without one,
+ *  and that the index follows changes to the attribute and to the tree,
+ *  in document order.
+ */
+
+bool
+basic_test_26 (bool verbose)
+{
+    std::cout
+        << "Test 26: Attribute indexes answer equality predicates."
+        << std::endl
+        ;
+
+    xml66::XMLTree plain { "tests/data/TestSession.ardour" };
+    xml66::XMLTree doc { "tests/data/TestSession.ardour" };
+    bool result { doc.build_index("Source", "id") };
+    const std::vector<std::string> exprs
+    {
+        "/Session/Sources/Source[@id='14457']",
+        "//Source[@id='14457']/@name",
+        "//Source['14457'=@id][@channel='0']",
+        "//Sources[Source[@id='14457']]",
+        "//Source[@id='14457' or @id='14361']",
+        "//Source[@id='none']"
+    };
+    std::size_t found { 0 };
+    for (const auto & e : exprs)
+    {
+        if (! result)
+            break;
+
+        xml66::SharedNodeListPtr expected { plain.find(e) };
+        xml66::SharedNodeListPtr actual { doc.find(e) };
+        result = actual->size() == expected->size();
+        for (std::size_t i = 0; result && i < actual->size(); ++i)
+            result = same_nodes(*(*actual)[i], *(*expected)[i]);
+
+        found += actual->size();
+    }
+    if (result)
+    {
+        const std::string by_id { "//Source[@id='14457']" };
+        xml66::XMLNodeRefList refs { doc.find_nodes(by_id) };
+        result = refs.size() == 1;
+        if (result)
+        {
+            xml66::XMLNode * source { refs.front().node };
+            (void) source->set_property("id", "99999");
+            result = doc.find(by_id)->empty() &&
+                doc.find_nodes("//Source[@id='99999']").front().node == source;
+        }
+        if (result)
+        {
+            refs.front().node->remove_property("id");
+            result = doc.find("//Source[@id='99999']")->empty();
+        }
+    }
+    if (result)                         /* edits keep document order        */
+    {
+        const std::string shared { "//Source[@id='shared']" };
+        std::vector<xml66::XMLTree *> trees { &plain, &doc };
+        for (auto t : trees)
+        {
+            xml66::XMLNodeRefList sources { t->find_nodes("//Source") };
+            result = sources.size() > 5;
+            if (! result)
+                break;
+
+            for (std::size_t i : { 4, 0, 2 })
+                (void) sources[i].node->set_property("id", "shared");
+
+            (void) sources[2].node->set_property("id", "moved");
+            (void) sources[3].node->set_property("id", "shared");
+            (void) t->root()->add_child("Note")->set_property("id", "shared");
+        }
+        std::vector<std::size_t> counts;
+        for (int step = 0; result && step < 3; ++step)
+        {
+            if (step == 1)                  /* a Source whose place is new  */
+            {
+                for (auto t : trees)
+                {
+                    xml66::XMLNode * s { t->root()->add_child("Source") };
+                    (void) s->set_property("id", "shared");
+                }
+            }
+            else if (step == 2)             /* removed subtree entries      */
+            {
+                for (auto t : trees)
+                {
+                    xml66::XMLNode * sources
+                    {
+                        t->find_nodes("/Session/Sources").front().node
+                    };
+                    sources->remove_nodes_and_delete("id", "shared");
+                }
+            }
+            xml66::SharedNodeListPtr expected { plain.find(shared) };
+            xml66::SharedNodeListPtr actual { doc.find(shared) };
+            result = actual->size() == expected->size();
+            for (std::size_t i = 0; result && i < actual->size(); ++i)
+                result = same_nodes(*(*actual)[i], *(*expected)[i]);
+
+            counts.push_back(actual->size());
+        }
+        if (result)
+            result = counts == std::vector<std::size_t> { 3, 4, 1 };
+    }
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << found << " nodes: "
+            << (result ? "ok" : "FAILED") << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Tests that simple paths are walked, that explain() reports the plans,
+ *  and that walked paths match libxml2.
+ */
+
+bool
+basic_test_27 (bool verbose)
+{
+    using plan = xml66::XMLTree::plan;
+
+    std::cout
+        << "Test 27: Simple paths are planned as walks."
+        << std::endl
+        ;
+
+    static const std::vector<std::string> s_paths
+    {
+        "/rosegarden-data/studio/device/bank",
+        "/rosegarden-data/studio/device[@id='0']/bank[@name='GM2 Standard']",
+        "/rosegarden-data/studio/device/bank[@percussion='true']/program",
+        "/rosegarden-data/studio/device/instrument[@nope='x']"
+    };
+    xml66::XMLTree doc { "tests/data/RosegardenPatchFile.xml" };
+    bool result { not_nullptr(doc.root()) };
+    std::size_t total { 0 };
+    for (const auto & xpath : s_paths)
+    {
+        if (! result)
+            break;
+
+        const std::string unplanned { xpath + " | /following::none" };
+        xml66::SharedNodeListPtr walked { doc.find(xpath) };
+        xml66::SharedNodeListPtr expected { doc.find(unplanned) };
+        result = doc.explain(xpath) == plan::walk &&
+            doc.explain(unplanned) == plan::document &&
+            walked->size() == expected->size();
+
+        for (std::size_t i = 0; result && i < walked->size(); ++i)
+            result = same_nodes(*(*walked)[i], *(*expected)[i]);
+
+        total += walked->size();
+    }
+    if (result)
+    {
+        xml66::XMLNode * root { doc.root() };
+        const std::string path { "/rosegarden-data/studio/device[@id='0']" };
+        result =
+            doc.explain("//device") == plan::document &&
+            doc.explain("//device", root) == plan::native &&
+            doc.explain("(//device)[1]", root) == plan::libxml &&
+            doc.explain(path) == plan::walk &&
+            doc.build_index("device", "id") &&
+            doc.explain(path) == plan::index &&
+            doc.explain("//device[@id='0']") == plan::index &&
+            doc.find(path)->size() == 1;
+    }
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << total << " nodes: "
+            << (result ? "ok" : "FAILED") << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Tests that find_many() matches separate find() calls, for expressions
+ *  that share its single pass and for those that do not, including numeric
+ *  comparisons that the native pass must evaluate as libxml2 does.
+ */
+
+bool
+basic_test_28 (bool verbose)
+{
+    std::cout
+        << "Test 28: Batches of queries in one pass."
+        << std::endl
+        ;
+
+    static const std::vector<std::string> s_expressions
+    {
+        "//Source",
+        "//Route",
+        "//Playlist[@orig-diskstream-id]",
+        "//Region[@name]/@name",
+        "//Location[starts-with(@name, 'Loop')]",
+        "/Session//Route//Port",
+        "/Session/Sources/Source",              /* walked                   */
+        "(//Region)[2]",                        /* libxml2                  */
+        "//Route[1]",                           /* positional               */
+        "//NoSuchElement"
+    };
+    xml66::XMLTree doc { "tests/data/TestSession.ardour" };
+    std::vector<xml66::SharedNodeListPtr> many { doc.find_many(s_expressions) };
+    bool result { many.size() == s_expressions.size() };
+    std::size_t total { 0 };
+    for (std::size_t i = 0; result && i < many.size(); ++i)
+    {
+        xml66::SharedNodeListPtr one { doc.find(s_expressions[i]) };
+        result = one->size() == many[i]->size();
+        for (std::size_t j = 0; result && j < one->size(); ++j)
+            result = same_nodes(*(*one)[j], *(*many[i])[j]);
+
+        total += one->size();
+    }
+    if (result)
+    {
+        static const std::vector<std::string> s_numbers
+        {
+            "//p[@n > 0]",
+            "//p[@n > 2]/@n",
+            "//p[@n = 1000]",
+            "//p[@n = 1e3]"
+        };
+        xml66::XMLTree numbers;
+        result = numbers.read_buffer
+        (
+            "<r><p n='1e3'/><p n='0.1'/><p n='2.5'/><p n='-'/><p n='1E20'/>"
+            "<p n=' 7 '/><p n='.'/><p n='-2e-1'/></r>", true
+        ) && numbers.explain(s_numbers[0]) == xml66::XMLTree::plan::document;
+
+        std::vector<xml66::SharedNodeListPtr> batch
+        {
+            numbers.find_many(s_numbers)
+        };
+        for (std::size_t i = 0; result && i < batch.size(); ++i)
+        {
+            std::size_t count { numbers.find(s_numbers[i])->size() };
+            result = count > 0 && batch[i]->size() == count;
+            if (verbose || ! result)
+            {
+                std::cout
+                    << "   " << s_numbers[i] << ": " << batch[i]->size()
+                    << " of " << count << " nodes" << std::endl
+                    ;
+            }
+        }
+    }
+    if (result)
+    {
+        xml66::XMLQueryPtr forward { doc.query("//Route") };
+        xml66::XMLQueryPtr positional { doc.query("//Route[1]") };
+        result = forward->native()->forward() &&
+            ! positional->native()->forward();
+    }
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << total << " nodes: "
+            << (result ? "ok" : "FAILED") << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Streams queries over a file and compares the nodes with those that
+ *  XMLTree::find() selects from the loaded tree.
+ */
+
+bool
+basic_test_29 (bool verbose)
+{
+    std::cout
+        << "Test 29: Streaming queries."
+        << std::endl
+        ;
+
+    static const std::string s_file { "tests/data/TestSession.ardour" };
+    static const std::vector<std::string> s_expressions
+    {
+        "/Session/Sources/Source[contains(@captured-for,'Guitar')]",
+        "/Session/Sources/Source",
+        "//Route",
+        "//*[@id]",                             /* nested selections        */
+        "//Region[@name]/@name",
+        "//Location[starts-with(@name, 'Loop')]",
+        "/Session//Route//Port",
+        "//NoSuchElement"
+    };
+    xml66::XMLTree doc { s_file };
+    bool result { true };
+    std::size_t total { 0 };
+    for (const auto & xpath : s_expressions)
+    {
+        xml66::SharedNodeListPtr found { doc.find(xpath) };
+        xml66::XMLStream stream { s_file, xpath };
+        std::size_t count { 0 };
+        while (xml66::XMLNodePtr node = stream.next())
+        {
+            result = count < found->size() &&
+                same_nodes(*node, *(*found)[count]);
+
+            if (! result)
+                break;
+
+            ++count;
+        }
+        if (result)
+            result = stream.good() && count == found->size();
+
+        if (! result)
+            break;
+
+        total += count;
+    }
+    if (result)
+    {
+        static const std::vector<std::string> s_unsupported
+        {
+            "//Source[Port]",                   /* needs the children       */
+            "//Route[1]",                       /* positional               */
+            "//Region[string-length() > 0]",    /* needs the content        */
+            "//Route/parent::*",                /* reverse axis             */
+            "Session/Sources"                   /* relative                 */
+        };
+        for (const auto & xpath : s_unsupported)
+        {
+            bool threw { false };
+            try
+            {
+                xml66::XMLStream stream { s_file, xpath };
+            }
+            catch (const xml66::XMLException &)
+            {
+                threw = true;
+            }
+            if (! threw)
+            {
+                result = false;
+                break;
+            }
+        }
+    }
+    if (result)
+    {
+        xml66::XMLStream missing { "tests/data/no-such-file.xml", "//Route" };
+        result = ! missing.next() && ! missing.good();
+    }
+    if (verbose || ! result)
+    {
+        std::cout
+            << "   " << total << " nodes: "
+            << (result ? "ok" : "FAILED") << std::endl
+            ;
+    }
+    return result;
+}
+
 }   // namespace anonymous
 
 /*
@@ -488,6 +2077,72 @@ main (int argc, char * argv [])
             if (success)
                 success = basic_test_7(verbose);
 
+            if (success)
+                success = basic_test_8(verbose);
+
+            if (success)
+                success = basic_test_9(verbose);
+
+            if (success)
+                success = basic_test_10(verbose);
+
+            if (success)
+                success = basic_test_11(verbose);
+
+            if (success)
+                success = basic_test_12(verbose);
+
+            if (success)
+                success = basic_test_13(verbose);
+
+            if (success)
+                success = basic_test_14(verbose);
+
+            if (success)
+                success = basic_test_15(verbose);
+
+            if (success)
+                success = basic_test_16(verbose);
+
+            if (success)
+                success = basic_test_17(verbose);
+
+            if (success)
+                success = basic_test_18(verbose);
+
+            if (success)
+                success = basic_test_19(verbose);
+
+            if (success)
+                success = basic_test_20(verbose);
+
+            if (success)
+                success = basic_test_21(verbose);
+
+            if (success)
+                success = basic_test_22(verbose);
+
+            if (success)
+                success = basic_test_23(verbose);
+
+            if (success)
+                success = basic_test_24(verbose);
+
+            if (success)
+                success = basic_test_25(verbose);
+
+            if (success)
+                success = basic_test_26(verbose);
+
+            if (success)
+                success = basic_test_27(verbose);
+
+            if (success)
+                success = basic_test_28(verbose);
+
+            if (success)
+                success = basic_test_29(verbose);
+
             if (success)
                 std::cout << "xml_tests has succeeded." << std::endl;
             else